@@ -0,0 +1,59 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bench/bench.h"
+
+static unsigned long allocs = 0;
+
+#ifdef __GLIBC__
+// Interpose the allocator to count allocations, glibc exports the real one
+// under these names.
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+	++allocs;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+	++allocs;
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+	++allocs;
+	return __libc_realloc(ptr, size);
+}
+#endif
+
+unsigned long bench_alloc_count(void) {
+	return allocs;
+}
+
+uint64_t bench_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void bench_run(const char *name, double min_seconds, unsigned long ops_per_call,
+		void (*fn)(void *data), void *data) {
+	uint64_t min_ns = min_seconds * 1e9;
+	unsigned long calls = 0;
+	unsigned long start_allocs = bench_alloc_count();
+	uint64_t start = bench_now_ns(), elapsed;
+	do {
+		fn(data);
+		++calls;
+		elapsed = bench_now_ns() - start;
+	} while (elapsed < min_ns);
+	unsigned long allocated = bench_alloc_count() - start_allocs;
+
+	double ops = (double)calls * ops_per_call;
+	printf("%-40s %10.0f ops %14.1f ns/op %10.2f allocs/op\n",
+			name, ops, elapsed / ops, allocated / ops);
+	fflush(stdout);
+}
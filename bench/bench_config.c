@@ -0,0 +1,183 @@
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include "bench/bench.h"
+#include "bench/headless.h"
+#include "sway/config.h"
+#include "list.h"
+#include "log.h"
+#include "readline.h"
+#include "stringop.h"
+
+static const char *keys[] = {
+	"a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m",
+	"n", "o", "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z",
+	"0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+	"F1", "F2", "F3", "F4", "F5", "F6", "F7", "F8", "F9", "F10", "F11", "F12",
+	"Return", "Escape", "Tab", "space", "Left", "Right", "Up", "Down",
+	"Home", "End", "Prior", "Next", "Insert", "Delete", "BackSpace",
+	"comma", "period", "slash", "minus", "equal",
+};
+
+static const char *modifiers[] = {
+	"", "Shift+", "Ctrl+", "Shift+Ctrl+", "Mod1+", "Mod1+Shift+",
+	"Mod1+Ctrl+", "Mod1+Shift+Ctrl+",
+};
+
+#define KEY_COUNT (sizeof(keys) / sizeof(keys[0]))
+#define MODIFIER_COUNT (sizeof(modifiers) / sizeof(modifiers[0]))
+
+static const char *binding_key(int n, char *buf, size_t size) {
+	snprintf(buf, size, "$mod+%s%s", modifiers[n / KEY_COUNT % MODIFIER_COUNT],
+			keys[n % KEY_COUNT]);
+	return buf;
+}
+
+/**
+ * Writes line i of a generated config, in chunks of 100 lines that mix the
+ * shapes found in real configs: comments, blank lines, variables, key
+ * bindings (some using variables, quotes or continuation lines), for_window
+ * rules and a mode block.
+ */
+static void write_line(FILE *f, int i) {
+	static int binding = 0;
+	char key[64];
+	int chunk = i / 100, n = i % 100;
+	if (n == 0) {
+		fprintf(f, "# chunk %d\n", chunk);
+	} else if (n == 1 || n == 59) {
+		fprintf(f, "\n");
+	} else if (n < 10) {
+		fprintf(f, "set $term%d foot --title \"chunk %d\"\n", n, chunk);
+	} else if (n < 39 && n % 10 == 9) {
+		fprintf(f, "bindsym %s exec $term%d \\\n", binding_key(binding++, key, sizeof(key)), n % 8 + 2);
+	} else if (n < 40 && n % 10 == 0 && n > 10) {
+		fprintf(f, "\t--working-directory ~/src/%d\n", chunk);
+	} else if (n < 40) {
+		fprintf(f, "    bindsym %s exec \"notify-send 'binding %d'\"\n",
+				binding_key(binding++, key, sizeof(key)), i);
+	} else if (n < 50) {
+		fprintf(f, "for_window [class=\"^app-%d$\" title=\"%d\"] floating enable\n", n, chunk);
+	} else if (n < 59) {
+		fprintf(f, "# comment %d, a longer one like the ones above a block of bindings\n", n);
+	} else if (n == 60) {
+		fprintf(f, "mode \"chunk-%d\" {\n", chunk);
+	} else if (n < 99) {
+		fprintf(f, "\tbindsym %s mode default\n", binding_key(n, key, sizeof(key)));
+	} else {
+		fprintf(f, "}\n");
+	}
+}
+
+static const char *config_path;
+static list_t *lines;
+
+static void run_load_main_config(void *data) {
+	load_main_config(config_path, false);
+}
+
+static void run_split_args(void *data) {
+	for (int i = 0; i < lines->length; ++i) {
+		int argc;
+		char **args = split_args(lines->items[i], &argc);
+		free_argv(argc, args);
+	}
+}
+
+static void run_split_args_buffer(void *data) {
+	struct split_buffer *buffer = data;
+	for (int i = 0; i < lines->length; ++i) {
+		int argc;
+		split_args_buffer(buffer, lines->items[i], &argc);
+	}
+}
+
+int main(int argc, char **argv) {
+	const char *usage =
+		"Usage: bench_config [options]\n"
+		"\n"
+		"  -h, --help              Show help message and quit.\n"
+		"  -l, --lines <n>         Number of config lines (default 10000).\n"
+		"  -t, --time <seconds>    Minimum time per benchmark (default 0.5).\n"
+		"\n";
+
+	static struct option long_options[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"lines", required_argument, NULL, 'l'},
+		{"time", required_argument, NULL, 't'},
+		{0, 0, 0, 0}
+	};
+
+	int line_count = 10000;
+	double seconds = 0.5;
+	int c;
+	while ((c = getopt_long(argc, argv, "hl:t:", long_options, NULL)) != -1) {
+		switch (c) {
+		case 'l':
+			line_count = atoi(optarg);
+			break;
+		case 't':
+			seconds = atof(optarg);
+			break;
+		default:
+			fprintf(stderr, "%s", usage);
+			exit(c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+	}
+
+	char path[] = "/tmp/sway-bench-config-XXXXXX";
+	int fd = mkstemp(path);
+	FILE *f = fd < 0 ? NULL : fdopen(fd, "w");
+	if (!f) {
+		perror("Unable to create config");
+		exit(EXIT_FAILURE);
+	}
+	fprintf(f, "set $mod Mod4\n");
+	for (int i = 1; i < line_count; ++i) {
+		write_line(f, i);
+	}
+	fclose(f);
+	config_path = path;
+
+	// the lines again for the tokenizer alone, minus comments and blank ones
+	lines = create_list();
+	f = fopen(path, "r");
+	char *line;
+	while (f && !feof(f)) {
+		if ((line = read_line(f))) {
+			line = strip_whitespace(line);
+			if (*line && *line != '#') {
+				list_add(lines, line);
+			} else {
+				free(line);
+			}
+		}
+	}
+	if (f) {
+		fclose(f);
+	}
+
+	init_log(L_SILENT);
+	if (!headless_init(NULL)) {
+		unlink(path);
+		exit(EXIT_FAILURE);
+	}
+	if (!load_main_config(path, false)) {
+		fprintf(stderr, "Generated config has errors\n");
+	}
+	printf("# %d lines, %d modes, %d for_window rules\n", line_count,
+			config->modes->length, config->criteria->length);
+
+	struct split_buffer buffer = { 0 };
+	bench_run("load_main_config", seconds, line_count, run_load_main_config, NULL);
+	bench_run("split_args", seconds, lines->length, run_split_args, NULL);
+	bench_run("split_args_buffer", seconds, lines->length, run_split_args_buffer, &buffer);
+
+	split_buffer_finish(&buffer);
+	free_flat_list(lines);
+	unlink(path);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "bench/bench.h"
+#include "bench/headless.h"
+#include "bench/wlc-stub.h"
+#include "sway/config.h"
+#include "sway/container.h"
+#include "sway/criteria.h"
+#include "intern.h"
+#include "list.h"
+#include "log.h"
+
+/**
+ * Appends rule i of a config with rules for_window rules, mixing the shapes
+ * found in real configs: mostly plain unanchored values as i3 users write
+ * them, then anchored values and prefixes, and a few regular expressions. The
+ * classes, instances and titles line up with the views created by map_views.
+ */
+static void append_rule(char *buf, size_t size, int i, int rules) {
+	int n = i / 8 % (rules / 8 + 1);
+	size_t len = strlen(buf);
+	buf += len;
+	size -= len;
+	switch (i % 8) {
+	case 0:
+		snprintf(buf, size, "for_window [class=\"app-%d\"] border pixel 1\n", n);
+		break;
+	case 1:
+		snprintf(buf, size, "for_window [instance=\"inst-%d\"] border pixel 2\n", n);
+		break;
+	case 2:
+		snprintf(buf, size, "for_window [class=\"app-%d\" title=\"Mail\"] border normal\n", n);
+		break;
+	case 3:
+		snprintf(buf, size, "for_window [class=\"^app-%d$\"] border pixel 3\n", n);
+		break;
+	case 4:
+		snprintf(buf, size, "for_window [class=\"^Tool\" title=\"^tool %d\"] border pixel 4\n", n);
+		break;
+	case 5:
+		snprintf(buf, size, "for_window [instance=\"^term-%d\"] border pixel 5\n", n);
+		break;
+	case 6:
+		snprintf(buf, size, "for_window [title=\"(compose|reply) %d$\"] border pixel 6\n", n);
+		break;
+	case 7:
+		snprintf(buf, size, "for_window [class=\"(?i)^APP-%d$\"] border pixel 7\n", n);
+		break;
+	}
+}
+
+static wlc_handle output;
+static list_t *handles;
+static list_t *views;
+
+static void map_views(int count, int rules) {
+	for (int i = 0; i < count; ++i) {
+		int n = i % (rules / 8 + 1);
+		char title[64], class[32], instance[32];
+		snprintf(title, sizeof(title), i % 3 ? "view %d" : "Mail - view %d", i);
+		snprintf(class, sizeof(class), "app-%d", n);
+		snprintf(instance, sizeof(instance), i % 2 ? "inst-%d" : "term-%d", n);
+		wlc_handle view = wlc_stub_view_create(output, title, NULL, class, instance, 0);
+		if (view) {
+			list_add(handles, (void *)view);
+		}
+	}
+}
+
+static void collect_view(swayc_t *container, void *data) {
+	if (container->type == C_VIEW) {
+		list_add(views, container);
+	}
+}
+
+static void run_criteria_for(void *data) {
+	for (int i = 0; i < views->length; ++i) {
+		list_free(criteria_for(views->items[i]));
+	}
+}
+
+static void run_criteria_any(void *data) {
+	for (int i = 0; i < views->length; ++i) {
+		criteria_any(views->items[i], config->criteria, &config->criteria_index);
+	}
+}
+
+static void run_criteria_index_build(void *data) {
+	criteria_index_build(&config->criteria_index, config->criteria);
+}
+
+static void run_container_for(void *data) {
+	list_free(container_for(data));
+}
+
+int main(int argc, char **argv) {
+	const char *usage =
+		"Usage: bench_criteria [options]\n"
+		"\n"
+		"  -h, --help              Show help message and quit.\n"
+		"  -r, --rules <n>         Number of for_window rules (default 400).\n"
+		"  -n, --views <n>         Number of views (default 200).\n"
+		"  -t, --time <seconds>    Minimum time per benchmark (default 0.5).\n"
+		"\n";
+
+	static struct option long_options[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"rules", required_argument, NULL, 'r'},
+		{"views", required_argument, NULL, 'n'},
+		{"time", required_argument, NULL, 't'},
+		{0, 0, 0, 0}
+	};
+
+	int rules = 400, view_count = 200;
+	double seconds = 0.5;
+	int c;
+	while ((c = getopt_long(argc, argv, "hr:n:t:", long_options, NULL)) != -1) {
+		switch (c) {
+		case 'r':
+			rules = atoi(optarg);
+			break;
+		case 'n':
+			view_count = atoi(optarg);
+			break;
+		case 't':
+			seconds = atof(optarg);
+			break;
+		default:
+			fprintf(stderr, "%s", usage);
+			exit(c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+	}
+
+	size_t size = (size_t)rules * 96 + 1;
+	char *bench_config = calloc(1, size);
+	if (!bench_config) {
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 0; i < rules; ++i) {
+		append_rule(bench_config, size, i, rules);
+	}
+
+	init_log(L_ERROR);
+	if (!headless_init(bench_config)) {
+		exit(EXIT_FAILURE);
+	}
+	free(bench_config);
+	headless_create_outputs(1, 1920, 1080, &output);
+
+	handles = create_list();
+	views = create_list();
+	map_views(view_count, rules);
+	container_map(&root_container, collect_view, NULL);
+	printf("# %d rules, %d views\n", config->criteria->length, views->length);
+	const struct intern_stats *stats = get_intern_stats();
+	printf("# interned: %zu strings, %zu references, %zu bytes, %zu bytes saved\n",
+			stats->strings, stats->references, stats->bytes, stats->saved);
+
+	list_t *exact = create_list(), *title = create_list(), *con_id = create_list();
+	char con_id_criteria[32];
+	swayc_t *middle = views->length ? views->items[views->length / 2] : &root_container;
+	snprintf(con_id_criteria, sizeof(con_id_criteria), "[con_id=%zu]", middle->id);
+	char *error = extract_crit_tokens(exact, "[class=\"^app-1$\"]");
+	if (!error) {
+		error = extract_crit_tokens(title, "[title=\"Mail\" instance=\"^term-\"]");
+	}
+	if (!error) {
+		error = extract_crit_tokens(con_id, con_id_criteria);
+	}
+	if (error) {
+		fprintf(stderr, "%s\n", error);
+		exit(EXIT_FAILURE);
+	}
+
+	bench_run("criteria_for", seconds, views->length, run_criteria_for, NULL);
+	bench_run("criteria_any", seconds, views->length, run_criteria_any, NULL);
+	bench_run("criteria_index_build", seconds, 1, run_criteria_index_build, NULL);
+	bench_run("container_for/class", seconds, 1, run_container_for, exact);
+	bench_run("container_for/title", seconds, 1, run_container_for, title);
+	bench_run("container_for/con_id", seconds, 1, run_container_for, con_id);
+
+	free_crit_tokens(exact);
+	free_crit_tokens(title);
+	free_crit_tokens(con_id);
+	for (int i = 0; i < handles->length; ++i) {
+		wlc_stub_view_destroy((wlc_handle)handles->items[i]);
+	}
+	list_free(handles);
+	list_free(views);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,262 @@
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <getopt.h>
+#include "bench/bench.h"
+#include "bench/headless.h"
+#include "bench/wlc-stub.h"
+#include "sway/container.h"
+#include "sway/focus.h"
+#include "sway/layout.h"
+#include "list.h"
+#include "log.h"
+
+static const char *bench_config =
+	"for_window [class=\"float\"] floating enable\n";
+
+static wlc_handle output;
+static list_t *handles;
+
+static void map_view(const char *class) {
+	char title[32];
+	snprintf(title, sizeof(title), "view %d", handles->length);
+	wlc_handle view = wlc_stub_view_create(output, title, NULL, class, "bench", 0);
+	if (view) {
+		list_add(handles, (void *)view);
+	}
+}
+
+static void switch_workspace(int number) {
+	char command[32];
+	snprintf(command, sizeof(command), "workspace %d", number);
+	headless_command(command);
+}
+
+static void build_wide(int views, int workspaces) {
+	for (int i = 0; i < views; ++i) {
+		map_view("tiled");
+	}
+}
+
+static void build_deep(int views, int workspaces) {
+	for (int i = 0; i < views; ++i) {
+		map_view("tiled");
+		headless_command(i % 2 ? "splitv" : "splith");
+	}
+}
+
+static void build_tabbed(int views, int workspaces) {
+	int per_workspace = (views + workspaces - 1) / workspaces;
+	for (int ws = 0; ws < workspaces; ++ws) {
+		switch_workspace(ws + 1);
+		headless_command("layout tabbed");
+		for (int i = 0; i < per_workspace && handles->length < views; ++i) {
+			map_view("tiled");
+		}
+	}
+}
+
+static void build_auto(int views, int workspaces) {
+	headless_command("layout auto left");
+	headless_command("layout auto master set 16");
+	headless_command("layout auto ncol set 8");
+	for (int i = 0; i < views; ++i) {
+		map_view("tiled");
+	}
+}
+
+static void build_floating(int views, int workspaces) {
+	for (int i = 0; i < views; ++i) {
+		map_view("float");
+	}
+}
+
+/**
+ * Mix of everything, spread over workspaces like a long running session.
+ */
+static void build_mixed(int views, int workspaces) {
+	int per_workspace = (views + workspaces - 1) / workspaces;
+	for (int ws = 0; ws < workspaces; ++ws) {
+		switch_workspace(ws + 1);
+		if (ws % 4 == 0) {
+			headless_command("layout tabbed");
+		}
+		for (int i = 0; i < per_workspace && handles->length < views; ++i) {
+			map_view(ws % 4 == 3 && i % 2 ? "float" : "tiled");
+			if (ws % 4 == 1) {
+				headless_command(i % 2 ? "splitv" : "splith");
+			}
+		}
+	}
+}
+
+struct shape {
+	const char *name;
+	void (*build)(int views, int workspaces);
+	int views, workspaces;
+};
+
+// deep trees recurse once per level, keep them within the default stack
+static struct shape shapes[] = {
+	{ "wide", build_wide, 10000, 1 },
+	{ "deep", build_deep, 1000, 1 },
+	{ "tabbed", build_tabbed, 10000, 40 },
+	{ "auto", build_auto, 10000, 1 },
+	{ "floating", build_floating, 10000, 1 },
+	{ "mixed", build_mixed, 500, 40 },
+};
+
+static list_t *views;
+
+static void collect_view(swayc_t *container, void *data) {
+	if (container->type == C_VIEW) {
+		list_add(views, container);
+	}
+}
+
+static void invalidate_layout_cache(swayc_t *container, void *data) {
+	container->layout_cache.valid = false;
+}
+
+static void run_arrange_windows_full(void *data) {
+	container_map(&root_container, invalidate_layout_cache, NULL);
+	arrange_windows(&root_container, -1, -1);
+}
+
+static void run_arrange_windows_unchanged(void *data) {
+	arrange_windows(&root_container, -1, -1);
+}
+
+static void run_update_geometry(void *data) {
+	for (int i = 0; i < views->length; ++i) {
+		update_geometry(views->items[i]);
+	}
+}
+
+static void run_get_swayc_in_direction(void *data) {
+	for (int i = 0; i < views->length; ++i) {
+		swayc_t *view = views->items[i];
+		get_swayc_in_direction(view, MOVE_LEFT);
+		get_swayc_in_direction(view, MOVE_RIGHT);
+		get_swayc_in_direction(view, MOVE_UP);
+		get_swayc_in_direction(view, MOVE_DOWN);
+	}
+}
+
+static void run_swayc_by_handle(void *data) {
+	for (int i = 0; i < handles->length; ++i) {
+		swayc_by_handle((wlc_handle)handles->items[i]);
+	}
+}
+
+static void run_move_container(void *data) {
+	swayc_t *view = get_focused_view(&root_container);
+	if (view && view->type == C_VIEW) {
+		move_container(view, MOVE_LEFT, 1);
+		move_container(view, MOVE_RIGHT, 1);
+	}
+}
+
+static void run_shape(struct shape *shape, double seconds) {
+	handles = create_list();
+	struct arrange_stats before = *get_arrange_stats();
+	shape->build(shape->views, shape->workspaces);
+	flush_arrange_windows();
+	const struct arrange_stats *after = get_arrange_stats();
+
+	views = create_list();
+	container_map(&root_container, collect_view, NULL);
+	printf("# %s: %d views on %d workspaces\n", shape->name, views->length, shape->workspaces);
+	// how well building the tree coalesced its arrange requests
+	printf("# %s: %lu arrange requests, %lu flushes, %lu layout passes\n", shape->name,
+			after->requests - before.requests, after->flushes - before.flushes,
+			after->arranged - before.arranged);
+
+	char name[64];
+#define BENCH(op, ops) \
+	snprintf(name, sizeof(name), "%s/%s", shape->name, #op); \
+	bench_run(name, seconds, ops, run_##op, NULL);
+
+	BENCH(arrange_windows_full, 1);
+	BENCH(arrange_windows_unchanged, 1);
+	BENCH(update_geometry, views->length);
+	BENCH(get_swayc_in_direction, views->length * 4);
+	BENCH(swayc_by_handle, handles->length);
+	BENCH(move_container, 2);
+#undef BENCH
+
+	for (int i = 0; i < handles->length; ++i) {
+		wlc_stub_view_destroy((wlc_handle)handles->items[i]);
+	}
+	switch_workspace(1);
+	list_free(handles);
+	list_free(views);
+}
+
+int main(int argc, char **argv) {
+	const char *usage =
+		"Usage: bench_layout [options]\n"
+		"\n"
+		"  -h, --help              Show help message and quit.\n"
+		"  -s, --shape <name>      Only run wide, deep, tabbed, auto, floating or mixed.\n"
+		"  -n, --views <n>         Number of views instead of the shape's default.\n"
+		"  -w, --workspaces <n>    Number of workspaces for tabbed and mixed.\n"
+		"  -t, --time <seconds>    Minimum time per benchmark (default 0.5).\n"
+		"\n";
+
+	static struct option long_options[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"shape", required_argument, NULL, 's'},
+		{"views", required_argument, NULL, 'n'},
+		{"workspaces", required_argument, NULL, 'w'},
+		{"time", required_argument, NULL, 't'},
+		{0, 0, 0, 0}
+	};
+
+	const char *only = NULL;
+	int views = 0, workspaces = 0;
+	double seconds = 0.5;
+	int c;
+	while ((c = getopt_long(argc, argv, "hs:n:w:t:", long_options, NULL)) != -1) {
+		switch (c) {
+		case 's':
+			only = optarg;
+			break;
+		case 'n':
+			views = atoi(optarg);
+			break;
+		case 'w':
+			workspaces = atoi(optarg);
+			break;
+		case 't':
+			seconds = atof(optarg);
+			break;
+		default:
+			fprintf(stderr, "%s", usage);
+			exit(c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+	}
+
+	init_log(L_ERROR);
+	if (!headless_init(bench_config)) {
+		exit(EXIT_FAILURE);
+	}
+	headless_create_outputs(1, 1920, 1080, &output);
+
+	for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i) {
+		struct shape *shape = &shapes[i];
+		if (only && strcasecmp(only, shape->name) != 0) {
+			continue;
+		}
+		if (views > 0) {
+			shape->views = views;
+		}
+		if (workspaces > 0) {
+			shape->workspaces = workspaces;
+		}
+		run_shape(shape, seconds);
+	}
+	return EXIT_SUCCESS;
+}
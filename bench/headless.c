@@ -0,0 +1,81 @@
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench/headless.h"
+#include "bench/wlc-stub.h"
+#include "sway/commands.h"
+#include "sway/config.h"
+#include "sway/handlers.h"
+#include "sway/input.h"
+#include "sway/layout.h"
+#include "sway.h"
+#include "list.h"
+#include "log.h"
+
+void sway_terminate(int exit_code) {
+	// there is no event loop to stop, the benchmarks decide when to exit
+	sway_log(L_INFO, "Ignoring request to terminate with %d", exit_code);
+}
+
+static bool load_config(const char *text) {
+	char path[] = "/tmp/sway-headless-XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0) {
+		sway_log_errno(L_ERROR, "Unable to create temporary config");
+		return false;
+	}
+	FILE *f = fdopen(fd, "w");
+	if (!f) {
+		close(fd);
+		unlink(path);
+		return false;
+	}
+	if (text) {
+		fputs(text, f);
+	}
+	fclose(f);
+	bool success = load_main_config(path, false);
+	unlink(path);
+	return success;
+}
+
+bool headless_init(const char *config) {
+	input_devices = create_list();
+	register_wlc_handlers();
+	if (!wlc_init()) {
+		return false;
+	}
+	init_layout();
+	if (!load_config(config)) {
+		return false;
+	}
+	wlc_stub_ready();
+	return true;
+}
+
+void headless_create_outputs(int count, uint32_t width, uint32_t height, wlc_handle *outputs) {
+	for (int i = 0; i < count; ++i) {
+		char name[32];
+		snprintf(name, sizeof(name), "HEADLESS-%d", i + 1);
+		wlc_handle output = wlc_stub_output_create(name, width, height);
+		if (outputs) {
+			outputs[i] = output;
+		}
+	}
+	flush_arrange_windows();
+}
+
+bool headless_command(const char *command) {
+	char *exec = strdup(command);
+	struct cmd_results *res = handle_command(exec, CONTEXT_IPC);
+	bool success = res->status == CMD_SUCCESS;
+	if (!success) {
+		sway_log(L_ERROR, "Command '%s' failed: %s", command, res->error);
+	}
+	free_cmd_results(res);
+	free(exec);
+	flush_arrange_windows();
+	return success;
+}
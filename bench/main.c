@@ -0,0 +1,124 @@
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "bench/headless.h"
+#include "bench/wlc-stub.h"
+#include "readline.h"
+#include "log.h"
+
+static char *read_file(const char *path) {
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		return NULL;
+	}
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	char *text = malloc(size + 1);
+	if (text) {
+		size_t len = fread(text, 1, size, f);
+		text[len] = '\0';
+	}
+	fclose(f);
+	return text;
+}
+
+int main(int argc, char **argv) {
+	const char *usage =
+		"Usage: sway-headless [options] < commands\n"
+		"\n"
+		"Runs the sway core without a display, executing one command per line.\n"
+		"\n"
+		"  -h, --help             Show help message and quit.\n"
+		"  -c, --config <config>  Load this config instead of an empty one.\n"
+		"  -o, --outputs <n>      Number of 1920x1080 outputs (default 1).\n"
+		"  -n, --views <n>        Number of views to map before reading commands.\n"
+		"  -d, --debug            Enables full logging, including debug information.\n"
+		"\n";
+
+	static struct option long_options[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"config", required_argument, NULL, 'c'},
+		{"outputs", required_argument, NULL, 'o'},
+		{"views", required_argument, NULL, 'n'},
+		{"debug", no_argument, NULL, 'd'},
+		{0, 0, 0, 0}
+	};
+
+	char *config = NULL;
+	int outputs = 1, views = 0;
+	log_importance_t verbosity = L_ERROR;
+	int c;
+	while ((c = getopt_long(argc, argv, "hc:o:n:d", long_options, NULL)) != -1) {
+		switch (c) {
+		case 'c':
+			free(config);
+			if (!(config = read_file(optarg))) {
+				fprintf(stderr, "Unable to read %s\n", optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'o':
+			outputs = atoi(optarg);
+			break;
+		case 'n':
+			views = atoi(optarg);
+			break;
+		case 'd':
+			verbosity = L_DEBUG;
+			break;
+		default:
+			fprintf(stderr, "%s", usage);
+			exit(c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+	}
+
+	init_log(verbosity);
+	if (!headless_init(config)) {
+		exit(EXIT_FAILURE);
+	}
+	free(config);
+
+	if (outputs < 1) {
+		outputs = 1;
+	}
+	wlc_handle *handles = calloc(outputs, sizeof(wlc_handle));
+	if (!handles) {
+		exit(EXIT_FAILURE);
+	}
+	headless_create_outputs(outputs, 1920, 1080, handles);
+	// views map where the focus is, so focus each output in turn for its share
+	for (int o = 0; o < outputs; ++o) {
+		char command[64];
+		snprintf(command, sizeof(command), "focus output HEADLESS-%d", o + 1);
+		if (outputs > 1) {
+			headless_command(command);
+		}
+		for (int i = o; i < views; i += outputs) {
+			char title[32];
+			snprintf(title, sizeof(title), "view %d", i);
+			wlc_stub_view_create(handles[o], title, NULL, "headless", "headless", 0);
+		}
+	}
+	free(handles);
+	wlc_stub_render();
+
+	int failed = 0;
+	char *line;
+	// read_line returns an empty line at the end of the input, not NULL
+	while (!feof(stdin) && (line = read_line(stdin))) {
+		if (*line && *line != '#' && !headless_command(line)) {
+			++failed;
+		}
+		free(line);
+		wlc_stub_render();
+	}
+
+	struct wlc_stub_stats *stats = wlc_stub_get_stats();
+	printf("frames: %lu\nview_set_geometry: %lu\nview_set_mask: %lu\npixels_write: %lu\n",
+			stats->frames, stats->view_set_geometry, stats->view_set_mask,
+			stats->pixels_write);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,816 @@
+#define _XOPEN_SOURCE 700
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <time.h>
+#include <wlc/wlc.h>
+#include <wlc/wlc-render.h>
+#include <wlc/wlc-wayland.h>
+#include "bench/wlc-stub.h"
+#include "hashmap.h"
+#include "list.h"
+#include "log.h"
+
+struct stub_output {
+	char *name;
+	struct wlc_size resolution;
+	uint32_t scale;
+	uint32_t mask;
+	bool render_scheduled;
+};
+
+struct stub_view {
+	wlc_handle output;
+	struct wlc_geometry geometry;
+	uint32_t state;
+	uint32_t type;
+	uint32_t mask;
+	pid_t pid;
+	char *title, *app_id, *class, *instance;
+	bool closing;
+};
+
+struct wlc_event_source {
+	int fd;
+	uint32_t mask;
+	int (*fd_cb)(int fd, uint32_t mask, void *userdata);
+	int (*timer_cb)(void *userdata);
+	void *userdata;
+	// CLOCK_MONOTONIC milliseconds, 0 if the timer is not armed
+	long long deadline;
+};
+
+static struct {
+	bool (*output_created)(wlc_handle output);
+	void (*output_destroyed)(wlc_handle output);
+	void (*output_focus)(wlc_handle output, bool focus);
+	void (*output_resolution)(wlc_handle output, const struct wlc_size *from, const struct wlc_size *to);
+	void (*output_render_pre)(wlc_handle output);
+	void (*output_render_post)(wlc_handle output);
+	bool (*view_created)(wlc_handle view);
+	void (*view_destroyed)(wlc_handle view);
+	void (*view_focus)(wlc_handle view, bool focus);
+	void (*view_request_geometry)(wlc_handle view, const struct wlc_geometry *geometry);
+	void (*view_request_state)(wlc_handle view, enum wlc_view_state_bit state, bool toggle);
+	void (*view_render_pre)(wlc_handle view);
+	void (*view_properties_updated)(wlc_handle view, uint32_t mask);
+	bool (*keyboard_key)(wlc_handle view, uint32_t time, const struct wlc_modifiers *modifiers,
+			uint32_t key, enum wlc_key_state state);
+	bool (*pointer_button)(wlc_handle view, uint32_t time, const struct wlc_modifiers *modifiers,
+			uint32_t button, enum wlc_button_state state, const struct wlc_point *position);
+	bool (*pointer_scroll)(wlc_handle view, uint32_t time, const struct wlc_modifiers *modifiers,
+			uint8_t axis_bits, double amount[2]);
+	bool (*pointer_motion)(wlc_handle view, uint32_t time, double x, double y);
+	void (*compositor_ready)(void);
+	bool (*input_created)(struct libinput_device *device);
+	void (*input_destroyed)(struct libinput_device *device);
+} callbacks;
+
+static hashmap_t *outputs = NULL, *views = NULL;
+// creation order, wlc reports outputs and stacks views in this order
+static list_t *output_list = NULL, *view_list = NULL;
+static list_t *sources = NULL;
+static wlc_handle focused_output = 0, focused_view = 0;
+static double pointer_x = 0, pointer_y = 0;
+static uint32_t time_ms = 0;
+static struct wlc_stub_stats stats;
+
+static void init_state(void) {
+	if (!outputs) {
+		outputs = create_hashmap(hash_ptr, compare_ptr);
+		views = create_hashmap(hash_ptr, compare_ptr);
+		output_list = create_list();
+		view_list = create_list();
+		sources = create_list();
+	}
+}
+
+static struct stub_output *get_output(wlc_handle handle) {
+	return outputs ? hashmap_get(outputs, (void *)handle) : NULL;
+}
+
+static struct stub_view *get_view(wlc_handle handle) {
+	return views ? hashmap_get(views, (void *)handle) : NULL;
+}
+
+static void list_remove(list_t *list, void *item) {
+	for (int i = 0; i < list->length; ++i) {
+		if (list->items[i] == item) {
+			list_del(list, i);
+			return;
+		}
+	}
+}
+
+static long long now_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+struct wlc_stub_stats *wlc_stub_get_stats(void) {
+	return &stats;
+}
+
+void wlc_stub_reset_stats(void) {
+	memset(&stats, 0, sizeof(stats));
+}
+
+// Driving the compositor
+
+void wlc_stub_ready(void) {
+	if (callbacks.compositor_ready) {
+		callbacks.compositor_ready();
+	}
+}
+
+wlc_handle wlc_stub_output_create(const char *name, uint32_t width, uint32_t height) {
+	init_state();
+	struct stub_output *output = calloc(1, sizeof(struct stub_output));
+	if (!output) {
+		return 0;
+	}
+	output->name = strdup(name);
+	output->resolution = (struct wlc_size){ width, height };
+	output->scale = 1;
+	wlc_handle handle = (wlc_handle)output;
+	if (!hashmap_set(outputs, output, output)) {
+		free(output->name);
+		free(output);
+		return 0;
+	}
+	list_add(output_list, output);
+	if (callbacks.output_created && !callbacks.output_created(handle)) {
+		wlc_stub_output_destroy(handle);
+		return 0;
+	}
+	if (!focused_output) {
+		wlc_output_focus(handle);
+	}
+	return handle;
+}
+
+void wlc_stub_output_destroy(wlc_handle handle) {
+	struct stub_output *output = get_output(handle);
+	if (!output) {
+		return;
+	}
+	if (focused_output == handle) {
+		focused_output = 0;
+	}
+	if (callbacks.output_destroyed) {
+		callbacks.output_destroyed(handle);
+	}
+	hashmap_del(outputs, output);
+	list_remove(output_list, output);
+	free(output->name);
+	free(output);
+}
+
+wlc_handle wlc_stub_view_create(wlc_handle output, const char *title,
+		const char *app_id, const char *class, const char *instance, pid_t pid) {
+	init_state();
+	struct stub_view *view = calloc(1, sizeof(struct stub_view));
+	if (!view) {
+		return 0;
+	}
+	view->output = output;
+	view->pid = pid;
+	view->title = title ? strdup(title) : NULL;
+	view->app_id = app_id ? strdup(app_id) : NULL;
+	view->class = class ? strdup(class) : NULL;
+	view->instance = instance ? strdup(instance) : NULL;
+	wlc_handle handle = (wlc_handle)view;
+	if (!hashmap_set(views, view, view)) {
+		free(view->title);
+		free(view->app_id);
+		free(view->class);
+		free(view->instance);
+		free(view);
+		return 0;
+	}
+	list_add(view_list, view);
+	if (callbacks.view_created && !callbacks.view_created(handle)) {
+		wlc_stub_view_destroy(handle);
+		return 0;
+	}
+	return handle;
+}
+
+void wlc_stub_view_destroy(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	if (!view) {
+		return;
+	}
+	if (callbacks.view_destroyed) {
+		callbacks.view_destroyed(handle);
+	}
+	if (focused_view == handle) {
+		focused_view = 0;
+	}
+	hashmap_del(views, view);
+	list_remove(view_list, view);
+	free(view->title);
+	free(view->app_id);
+	free(view->class);
+	free(view->instance);
+	free(view);
+}
+
+void wlc_stub_view_set_title(wlc_handle handle, const char *title) {
+	struct stub_view *view = get_view(handle);
+	if (!view) {
+		return;
+	}
+	free(view->title);
+	view->title = title ? strdup(title) : NULL;
+	if (callbacks.view_properties_updated) {
+		callbacks.view_properties_updated(handle, WLC_BIT_PROPERTY_TITLE);
+	}
+}
+
+void wlc_stub_view_set_type(wlc_handle handle, uint32_t type) {
+	struct stub_view *view = get_view(handle);
+	if (view) {
+		view->type = type;
+	}
+}
+
+bool wlc_stub_key(uint32_t key, uint32_t modifiers, enum wlc_key_state state) {
+	struct wlc_modifiers mods = { .leds = 0, .mods = modifiers };
+	if (!callbacks.keyboard_key) {
+		return false;
+	}
+	return callbacks.keyboard_key(focused_view, ++time_ms, &mods, key, state);
+}
+
+bool wlc_stub_button(uint32_t button, uint32_t modifiers, enum wlc_button_state state) {
+	struct wlc_modifiers mods = { .leds = 0, .mods = modifiers };
+	struct wlc_point position = { .x = pointer_x, .y = pointer_y };
+	if (!callbacks.pointer_button) {
+		return false;
+	}
+	return callbacks.pointer_button(focused_view, ++time_ms, &mods, button, state, &position);
+}
+
+bool wlc_stub_pointer_motion(double x, double y) {
+	if (!callbacks.pointer_motion) {
+		pointer_x = x;
+		pointer_y = y;
+		return false;
+	}
+	// like wlc, the callback is expected to move the pointer itself
+	return callbacks.pointer_motion(focused_view, ++time_ms, x, y);
+}
+
+void wlc_stub_render(void) {
+	if (!output_list) {
+		return;
+	}
+	for (int i = 0; i < output_list->length; ++i) {
+		struct stub_output *output = output_list->items[i];
+		if (!output->render_scheduled) {
+			continue;
+		}
+		output->render_scheduled = false;
+		wlc_handle handle = (wlc_handle)output;
+		if (callbacks.output_render_pre) {
+			callbacks.output_render_pre(handle);
+		}
+		for (int j = 0; j < view_list->length; ++j) {
+			struct stub_view *view = view_list->items[j];
+			if (view->output == handle && view->mask && callbacks.view_render_pre) {
+				callbacks.view_render_pre((wlc_handle)view);
+			}
+		}
+		if (callbacks.output_render_post) {
+			callbacks.output_render_post(handle);
+		}
+		stats.frames++;
+	}
+}
+
+int wlc_stub_dispatch(int timeout) {
+	init_state();
+	// views that were closed go away on the next iteration, like real
+	// clients that have to process the close request first
+	for (int i = 0; i < view_list->length; ) {
+		struct stub_view *view = view_list->items[i];
+		if (view->closing) {
+			wlc_stub_view_destroy((wlc_handle)view);
+		} else {
+			++i;
+		}
+	}
+
+	long long now = now_ms();
+	struct pollfd *fds = calloc(sources->length + 1, sizeof(struct pollfd));
+	struct wlc_event_source **fd_sources = calloc(sources->length + 1, sizeof(struct wlc_event_source *));
+	if (!fds || !fd_sources) {
+		free(fds);
+		free(fd_sources);
+		return -1;
+	}
+	int nfds = 0;
+	for (int i = 0; i < sources->length; ++i) {
+		struct wlc_event_source *source = sources->items[i];
+		if (source->fd_cb) {
+			fds[nfds].fd = source->fd;
+			fds[nfds].events = (source->mask & WLC_EVENT_READABLE ? POLLIN : 0)
+				| (source->mask & WLC_EVENT_WRITABLE ? POLLOUT : 0);
+			fd_sources[nfds++] = source;
+		} else if (source->deadline) {
+			int left = source->deadline > now ? (int)(source->deadline - now) : 0;
+			if (timeout < 0 || left < timeout) {
+				timeout = left;
+			}
+		}
+	}
+
+	int dispatched = 0;
+	if (poll(fds, nfds, timeout) >= 0) {
+		for (int i = 0; i < nfds; ++i) {
+			if (!fds[i].revents) {
+				continue;
+			}
+			uint32_t mask = (fds[i].revents & POLLIN ? WLC_EVENT_READABLE : 0)
+				| (fds[i].revents & POLLOUT ? WLC_EVENT_WRITABLE : 0)
+				| (fds[i].revents & POLLHUP ? WLC_EVENT_HANGUP : 0)
+				| (fds[i].revents & (POLLERR | POLLNVAL) ? WLC_EVENT_ERROR : 0);
+			// the source may have been removed by an earlier callback
+			if (list_seq_find(sources, compare_ptr, fd_sources[i]) < 0) {
+				continue;
+			}
+			fd_sources[i]->fd_cb(fd_sources[i]->fd, mask, fd_sources[i]->userdata);
+			++dispatched;
+		}
+	}
+	free(fds);
+	free(fd_sources);
+
+	now = now_ms();
+	for (int i = 0; i < sources->length; ++i) {
+		struct wlc_event_source *source = sources->items[i];
+		if (!source->fd_cb && source->deadline && source->deadline <= now) {
+			source->deadline = 0;
+			source->timer_cb(source->userdata);
+			++dispatched;
+		}
+	}
+	return dispatched;
+}
+
+// wlc.h
+
+void wlc_log_set_handler(void (*cb)(enum wlc_log_type type, const char *str)) {
+	// nothing logs
+}
+
+bool wlc_init(void) {
+	init_state();
+	return true;
+}
+
+void wlc_terminate(void) {
+	// nothing to tear down
+}
+
+void wlc_run(void) {
+	wlc_stub_ready();
+}
+
+struct wlc_event_source *wlc_event_loop_add_fd(int fd, uint32_t mask,
+		int (*cb)(int fd, uint32_t mask, void *userdata), void *userdata) {
+	init_state();
+	struct wlc_event_source *source = calloc(1, sizeof(struct wlc_event_source));
+	if (!source) {
+		return NULL;
+	}
+	source->fd = fd;
+	source->mask = mask;
+	source->fd_cb = cb;
+	source->userdata = userdata;
+	list_add(sources, source);
+	return source;
+}
+
+struct wlc_event_source *wlc_event_loop_add_timer(int (*cb)(void *userdata), void *userdata) {
+	init_state();
+	struct wlc_event_source *source = calloc(1, sizeof(struct wlc_event_source));
+	if (!source) {
+		return NULL;
+	}
+	source->fd = -1;
+	source->timer_cb = cb;
+	source->userdata = userdata;
+	list_add(sources, source);
+	return source;
+}
+
+bool wlc_event_source_timer_update(struct wlc_event_source *source, int32_t ms_delay) {
+	if (!source || source->fd_cb) {
+		return false;
+	}
+	source->deadline = ms_delay > 0 ? now_ms() + ms_delay : 0;
+	return true;
+}
+
+void wlc_event_source_remove(struct wlc_event_source *source) {
+	if (!source) {
+		return;
+	}
+	list_remove(sources, source);
+	free(source);
+}
+
+void wlc_set_output_created_cb(bool (*cb)(wlc_handle output)) {
+	callbacks.output_created = cb;
+}
+
+void wlc_set_output_destroyed_cb(void (*cb)(wlc_handle output)) {
+	callbacks.output_destroyed = cb;
+}
+
+void wlc_set_output_focus_cb(void (*cb)(wlc_handle output, bool focus)) {
+	callbacks.output_focus = cb;
+}
+
+void wlc_set_output_resolution_cb(void (*cb)(wlc_handle output,
+			const struct wlc_size *from, const struct wlc_size *to)) {
+	callbacks.output_resolution = cb;
+}
+
+void wlc_set_output_render_pre_cb(void (*cb)(wlc_handle output)) {
+	callbacks.output_render_pre = cb;
+}
+
+void wlc_set_output_render_post_cb(void (*cb)(wlc_handle output)) {
+	callbacks.output_render_post = cb;
+}
+
+void wlc_set_view_created_cb(bool (*cb)(wlc_handle view)) {
+	callbacks.view_created = cb;
+}
+
+void wlc_set_view_destroyed_cb(void (*cb)(wlc_handle view)) {
+	callbacks.view_destroyed = cb;
+}
+
+void wlc_set_view_focus_cb(void (*cb)(wlc_handle view, bool focus)) {
+	callbacks.view_focus = cb;
+}
+
+void wlc_set_view_request_geometry_cb(void (*cb)(wlc_handle view, const struct wlc_geometry *geometry)) {
+	callbacks.view_request_geometry = cb;
+}
+
+void wlc_set_view_request_state_cb(void (*cb)(wlc_handle view, enum wlc_view_state_bit state, bool toggle)) {
+	callbacks.view_request_state = cb;
+}
+
+void wlc_set_view_render_pre_cb(void (*cb)(wlc_handle view)) {
+	callbacks.view_render_pre = cb;
+}
+
+void wlc_set_view_properties_updated_cb(void (*cb)(wlc_handle view, uint32_t mask)) {
+	callbacks.view_properties_updated = cb;
+}
+
+void wlc_set_keyboard_key_cb(bool (*cb)(wlc_handle view, uint32_t time,
+			const struct wlc_modifiers *modifiers, uint32_t key, enum wlc_key_state state)) {
+	callbacks.keyboard_key = cb;
+}
+
+void wlc_set_pointer_button_cb(bool (*cb)(wlc_handle view, uint32_t time,
+			const struct wlc_modifiers *modifiers, uint32_t button,
+			enum wlc_button_state state, const struct wlc_point *position)) {
+	callbacks.pointer_button = cb;
+}
+
+void wlc_set_pointer_scroll_cb(bool (*cb)(wlc_handle view, uint32_t time,
+			const struct wlc_modifiers *modifiers, uint8_t axis_bits, double amount[2])) {
+	callbacks.pointer_scroll = cb;
+}
+
+void wlc_set_pointer_motion_cb_v2(bool (*cb)(wlc_handle view, uint32_t time, double x, double y)) {
+	callbacks.pointer_motion = cb;
+}
+
+void wlc_set_compositor_ready_cb(void (*cb)(void)) {
+	callbacks.compositor_ready = cb;
+}
+
+void wlc_set_input_created_cb(bool (*cb)(struct libinput_device *device)) {
+	callbacks.input_created = cb;
+}
+
+void wlc_set_input_destroyed_cb(void (*cb)(struct libinput_device *device)) {
+	callbacks.input_destroyed = cb;
+}
+
+wlc_handle wlc_get_focused_output(void) {
+	return focused_output;
+}
+
+const char *wlc_output_get_name(wlc_handle handle) {
+	struct stub_output *output = get_output(handle);
+	return output ? output->name : NULL;
+}
+
+const struct wlc_size *wlc_output_get_resolution(wlc_handle handle) {
+	struct stub_output *output = get_output(handle);
+	return output ? &output->resolution : NULL;
+}
+
+void wlc_output_set_resolution(wlc_handle handle, const struct wlc_size *resolution, uint32_t scale) {
+	struct stub_output *output = get_output(handle);
+	if (!output) {
+		return;
+	}
+	struct wlc_size from = output->resolution;
+	output->resolution = *resolution;
+	output->scale = scale ? scale : 1;
+	if (callbacks.output_resolution) {
+		callbacks.output_resolution(handle, &from, resolution);
+	}
+}
+
+uint32_t wlc_output_get_scale(wlc_handle handle) {
+	struct stub_output *output = get_output(handle);
+	return output ? output->scale : 1;
+}
+
+void wlc_output_set_mask(wlc_handle handle, uint32_t mask) {
+	struct stub_output *output = get_output(handle);
+	if (output) {
+		output->mask = mask;
+	}
+}
+
+void wlc_output_focus(wlc_handle handle) {
+	if (handle == focused_output) {
+		return;
+	}
+	wlc_handle old = focused_output;
+	focused_output = handle;
+	if (callbacks.output_focus) {
+		if (old) {
+			callbacks.output_focus(old, false);
+		}
+		if (handle) {
+			callbacks.output_focus(handle, true);
+		}
+	}
+}
+
+uint16_t wlc_output_get_gamma_size(wlc_handle output) {
+	return 0;
+}
+
+void wlc_output_set_gamma(wlc_handle output, uint16_t size, uint16_t *r, uint16_t *g, uint16_t *b) {
+	// there is no display to apply it to
+}
+
+void wlc_output_schedule_render(wlc_handle handle) {
+	struct stub_output *output = get_output(handle);
+	if (output) {
+		output->render_scheduled = true;
+	}
+	stats.schedule_render++;
+}
+
+void wlc_view_focus(wlc_handle handle) {
+	if (handle == focused_view) {
+		return;
+	}
+	wlc_handle old = focused_view;
+	focused_view = handle;
+	if (callbacks.view_focus) {
+		if (old) {
+			callbacks.view_focus(old, false);
+		}
+		if (handle) {
+			callbacks.view_focus(handle, true);
+		}
+	}
+}
+
+void wlc_view_close(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	if (view) {
+		view->closing = true;
+	}
+}
+
+wlc_handle wlc_view_get_output(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	return view ? view->output : 0;
+}
+
+void wlc_view_set_output(wlc_handle handle, wlc_handle output) {
+	struct stub_view *view = get_view(handle);
+	if (view) {
+		view->output = output;
+	}
+}
+
+static void restack_view(struct stub_view *view, bool front) {
+	list_remove(view_list, view);
+	if (front) {
+		list_add(view_list, view);
+	} else {
+		list_insert(view_list, 0, view);
+	}
+}
+
+void wlc_view_send_to_back(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	if (view) {
+		restack_view(view, false);
+	}
+}
+
+void wlc_view_bring_to_front(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	if (view) {
+		restack_view(view, true);
+	}
+}
+
+uint32_t wlc_view_get_mask(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	return view ? view->mask : 0;
+}
+
+void wlc_view_set_mask(wlc_handle handle, uint32_t mask) {
+	struct stub_view *view = get_view(handle);
+	if (view) {
+		view->mask = mask;
+	}
+	stats.view_set_mask++;
+}
+
+const struct wlc_geometry *wlc_view_get_geometry(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	return view ? &view->geometry : NULL;
+}
+
+void wlc_view_get_visible_geometry(wlc_handle handle, struct wlc_geometry *out_geometry) {
+	struct stub_view *view = get_view(handle);
+	*out_geometry = view ? view->geometry : wlc_geometry_zero;
+}
+
+void wlc_view_set_geometry(wlc_handle handle, uint32_t edges, const struct wlc_geometry *geometry) {
+	struct stub_view *view = get_view(handle);
+	if (view) {
+		view->geometry = *geometry;
+	}
+	stats.view_set_geometry++;
+}
+
+uint32_t wlc_view_get_type(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	return view ? view->type : 0;
+}
+
+uint32_t wlc_view_get_state(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	return view ? view->state : 0;
+}
+
+void wlc_view_set_state(wlc_handle handle, enum wlc_view_state_bit state, bool toggle) {
+	struct stub_view *view = get_view(handle);
+	if (!view) {
+		return;
+	}
+	if (toggle) {
+		view->state |= state;
+	} else {
+		view->state &= ~state;
+	}
+}
+
+wlc_handle wlc_view_get_parent(wlc_handle view) {
+	return 0;
+}
+
+const char *wlc_view_get_title(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	return view ? view->title : NULL;
+}
+
+const char *wlc_view_get_instance(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	return view ? view->instance : NULL;
+}
+
+const char *wlc_view_get_class(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	return view ? view->class : NULL;
+}
+
+const char *wlc_view_get_app_id(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	return view ? view->app_id : NULL;
+}
+
+pid_t wlc_view_get_pid(wlc_handle handle) {
+	struct stub_view *view = get_view(handle);
+	return view ? view->pid : 0;
+}
+
+const struct wlc_size *wlc_view_positioner_get_size(wlc_handle view) {
+	return NULL;
+}
+
+const struct wlc_geometry *wlc_view_positioner_get_anchor_rect(wlc_handle view) {
+	return NULL;
+}
+
+const struct wlc_point *wlc_view_positioner_get_offset(wlc_handle view) {
+	return NULL;
+}
+
+enum wlc_positioner_anchor_bit wlc_view_positioner_get_anchor(wlc_handle view) {
+	return WLC_BIT_ANCHOR_NONE;
+}
+
+enum wlc_positioner_gravity_bit wlc_view_positioner_get_gravity(wlc_handle view) {
+	return WLC_BIT_GRAVITY_NONE;
+}
+
+uint32_t wlc_keyboard_get_keysym_for_key(uint32_t key, const struct wlc_modifiers *modifiers) {
+	// there is no keymap, keys are reported as their keysyms
+	return key;
+}
+
+void wlc_pointer_get_position_v2(double *x, double *y) {
+	*x = pointer_x;
+	*y = pointer_y;
+}
+
+void wlc_pointer_set_position_v2(double x, double y) {
+	pointer_x = x;
+	pointer_y = y;
+}
+
+void wlc_set_selection(void *data, const char *const *types, size_t types_count,
+		void (*send)(void *data, const char *type, int fd)) {
+	// no clients to share it with
+}
+
+const char **wlc_get_selection_types(size_t *size) {
+	*size = 0;
+	return NULL;
+}
+
+bool wlc_get_selection_data(const char *type, int fd) {
+	return false;
+}
+
+// wlc-render.h
+
+void wlc_pixels_write(enum wlc_pixel_format format, const struct wlc_geometry *geometry, const void *data) {
+	stats.pixels_write++;
+}
+
+void wlc_pixels_read(enum wlc_pixel_format format, const struct wlc_geometry *geometry,
+		struct wlc_geometry *out_geometry, void *out_data) {
+	*out_geometry = *geometry;
+	memset(out_data, 0, (size_t)geometry->size.w * geometry->size.h * 4);
+}
+
+// wlc-wayland.h, there is no wayland display so none of these resolve
+
+struct wl_display *wlc_get_wl_display(void) {
+	return NULL;
+}
+
+wlc_handle wlc_handle_from_wl_surface_resource(struct wl_resource *resource) {
+	return 0;
+}
+
+wlc_handle wlc_handle_from_wl_output_resource(struct wl_resource *resource) {
+	return 0;
+}
+
+wlc_resource wlc_resource_from_wl_surface_resource(struct wl_resource *resource) {
+	return 0;
+}
+
+const struct wlc_size *wlc_surface_get_size(wlc_resource surface) {
+	static const struct wlc_size zero = { 0, 0 };
+	return &zero;
+}
+
+struct wl_resource *wlc_surface_get_wl_resource(wlc_resource surface) {
+	return NULL;
+}
+
+wlc_resource wlc_view_get_surface(wlc_handle view) {
+	return 0;
+}
+
+struct wl_client *wlc_view_get_wl_client(wlc_handle view) {
+	return NULL;
+}
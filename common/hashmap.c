@@ -0,0 +1,167 @@
+#include <stdlib.h>
+#include <string.h>
+#include "hashmap.h"
+
+#define HASHMAP_MIN_CAPACITY 16
+
+hashmap_t *create_hashmap(uint32_t hash(const void *key),
+		int compare(const void *key, const void *cmp_to)) {
+	hashmap_t *map = malloc(sizeof(hashmap_t));
+	if (!map) {
+		return NULL;
+	}
+	map->capacity = HASHMAP_MIN_CAPACITY;
+	map->length = 0;
+	map->hash = hash;
+	map->compare = compare;
+	map->entries = calloc(map->capacity, sizeof(struct hashmap_entry));
+	if (!map->entries) {
+		free(map);
+		return NULL;
+	}
+	return map;
+}
+
+void hashmap_free(hashmap_t *map) {
+	if (map == NULL) {
+		return;
+	}
+	free(map->entries);
+	free(map);
+}
+
+static int hashmap_find(hashmap_t *map, const void *key, uint32_t hash) {
+	int mask = map->capacity - 1;
+	for (int i = hash & mask; ; i = (i + 1) & mask) {
+		struct hashmap_entry *entry = &map->entries[i];
+		if (!entry->used) {
+			return -1;
+		}
+		if (entry->hash == hash && map->compare(entry->key, key) == 0) {
+			return i;
+		}
+	}
+}
+
+static void hashmap_insert(hashmap_t *map, const void *key, void *value, uint32_t hash) {
+	int mask = map->capacity - 1;
+	int i = hash & mask;
+	while (map->entries[i].used) {
+		i = (i + 1) & mask;
+	}
+	map->entries[i].key = key;
+	map->entries[i].value = value;
+	map->entries[i].hash = hash;
+	map->entries[i].used = true;
+	map->length++;
+}
+
+/**
+ * Makes room for one more entry. Returns false if the table is too full to
+ * take it and couldn't grow.
+ */
+static bool hashmap_resize(hashmap_t *map) {
+	// keep the load factor under 3/4 so probe sequences stay short
+	if ((map->length + 1) * 4 < map->capacity * 3) {
+		return true;
+	}
+	struct hashmap_entry *entries = calloc(map->capacity * 2, sizeof(struct hashmap_entry));
+	if (!entries) {
+		// probes stop at a free entry, there must always be one left
+		return map->length + 1 < map->capacity;
+	}
+	struct hashmap_entry *old = map->entries;
+	int old_capacity = map->capacity;
+	map->entries = entries;
+	map->capacity *= 2;
+	map->length = 0;
+	for (int i = 0; i < old_capacity; ++i) {
+		if (old[i].used) {
+			hashmap_insert(map, old[i].key, old[i].value, old[i].hash);
+		}
+	}
+	free(old);
+	return true;
+}
+
+void *hashmap_get(hashmap_t *map, const void *key) {
+	int i = hashmap_find(map, key, map->hash(key));
+	return i < 0 ? NULL : map->entries[i].value;
+}
+
+bool hashmap_set(hashmap_t *map, const void *key, void *value) {
+	uint32_t hash = map->hash(key);
+	int i = hashmap_find(map, key, hash);
+	if (i >= 0) {
+		map->entries[i].key = key;
+		map->entries[i].value = value;
+		return true;
+	}
+	if (!hashmap_resize(map)) {
+		return false;
+	}
+	hashmap_insert(map, key, value, hash);
+	return true;
+}
+
+void *hashmap_del(hashmap_t *map, const void *key) {
+	int i = hashmap_find(map, key, map->hash(key));
+	if (i < 0) {
+		return NULL;
+	}
+	void *value = map->entries[i].value;
+	int mask = map->capacity - 1;
+	// shift following entries of the probe sequence back into the hole, so
+	// that lookups never need tombstones
+	for (int j = (i + 1) & mask; map->entries[j].used; j = (j + 1) & mask) {
+		int k = map->entries[j].hash & mask;
+		if ((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j))) {
+			map->entries[i] = map->entries[j];
+			i = j;
+		}
+	}
+	memset(&map->entries[i], 0, sizeof(struct hashmap_entry));
+	map->length--;
+	return value;
+}
+
+void hashmap_clear(hashmap_t *map) {
+	memset(map->entries, 0, sizeof(struct hashmap_entry) * map->capacity);
+	map->length = 0;
+}
+
+void hashmap_foreach(hashmap_t *map,
+		void (*callback)(const void *key, void *value, void *data), void *data) {
+	if (map == NULL || callback == NULL) {
+		return;
+	}
+	for (int i = 0; i < map->capacity; ++i) {
+		if (map->entries[i].used) {
+			callback(map->entries[i].key, map->entries[i].value, data);
+		}
+	}
+}
+
+uint32_t hash_ptr(const void *key) {
+	// Fibonacci hashing, handles and pids tend to be sequential or aligned
+	uint64_t h = (uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ull;
+	return (uint32_t)(h >> 32);
+}
+
+int compare_ptr(const void *key, const void *cmp_to) {
+	return key != cmp_to;
+}
+
+uint32_t hash_string(const void *key) {
+	// FNV-1a
+	uint32_t h = 2166136261u;
+	for (const unsigned char *s = key; *s; ++s) {
+		h ^= *s;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+int compare_string(const void *key, const void *cmp_to) {
+	return strcmp(key, cmp_to);
+}
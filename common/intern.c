@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "intern.h"
+#include "hashmap.h"
+
+struct interned {
+	uint32_t references;
+	uint32_t length;
+	char str[];
+};
+
+// interned->str -> struct interned
+static hashmap_t *table = NULL;
+static struct intern_stats stats = { 0 };
+// the strings alone, stats.bytes adds the table
+static size_t string_bytes = 0;
+
+static struct interned *get_interned(const char *str) {
+	return (struct interned *)(str - offsetof(struct interned, str));
+}
+
+const char *intern_string(const char *str) {
+	if (!str) {
+		return NULL;
+	}
+	if (!table && !(table = create_hashmap(hash_string, compare_string))) {
+		return NULL;
+	}
+	struct interned *interned = hashmap_get(table, str);
+	if (interned) {
+		return intern_ref(interned->str);
+	}
+	size_t length = strlen(str);
+	if (!(interned = malloc(sizeof(struct interned) + length + 1))) {
+		return NULL;
+	}
+	interned->references = 1;
+	interned->length = (uint32_t)length;
+	memcpy(interned->str, str, length + 1);
+	if (!hashmap_set(table, interned->str, interned)) {
+		free(interned);
+		return NULL;
+	}
+	stats.strings++;
+	stats.references++;
+	string_bytes += sizeof(struct interned) + length + 1;
+	return interned->str;
+}
+
+const char *intern_ref(const char *str) {
+	if (str) {
+		struct interned *interned = get_interned(str);
+		interned->references++;
+		stats.references++;
+		stats.saved += interned->length + 1;
+	}
+	return str;
+}
+
+void intern_release(const char *str) {
+	if (!str) {
+		return;
+	}
+	struct interned *interned = get_interned(str);
+	stats.references--;
+	if (--interned->references > 0) {
+		stats.saved -= interned->length + 1;
+		return;
+	}
+	hashmap_del(table, interned->str);
+	stats.strings--;
+	string_bytes -= sizeof(struct interned) + interned->length + 1;
+	free(interned);
+}
+
+const struct intern_stats *get_intern_stats(void) {
+	stats.bytes = string_bytes;
+	if (table) {
+		stats.bytes += sizeof(hashmap_t) + table->capacity * sizeof(struct hashmap_entry);
+	}
+	return &stats;
+}
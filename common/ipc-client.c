@@ -43,12 +43,24 @@ struct ipc_response *ipc_recv_response(int socketfd) {
 	char data[ipc_header_size];
 	uint32_t *data32 = (uint32_t *)(data + sizeof(ipc_magic));
 
+	// descriptors arrive with the first byte of the response
+	int fd = -1;
 	size_t total = 0;
 	while (total < ipc_header_size) {
-		ssize_t received = recv(socketfd, data + total, ipc_header_size - total, 0);
+		struct iovec iov = { data + total, ipc_header_size - total };
+		char control[CMSG_SPACE(sizeof(int))];
+		struct msghdr msg = {
+			.msg_iov = &iov, .msg_iovlen = 1,
+			.msg_control = control, .msg_controllen = sizeof(control),
+		};
+		ssize_t received = recvmsg(socketfd, &msg, MSG_CMSG_CLOEXEC);
 		if (received <= 0) {
 			sway_abort("Unable to receive IPC response");
 		}
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+		if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+			memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+		}
 		total += received;
 	}
 
@@ -58,6 +70,7 @@ struct ipc_response *ipc_recv_response(int socketfd) {
 	}
 
 	total = 0;
+	response->fd = fd;
 	response->size = data32[0];
 	response->type = data32[1];
 	char *payload = malloc(response->size + 1);
@@ -79,33 +92,46 @@ struct ipc_response *ipc_recv_response(int socketfd) {
 error_2:
 	free(response);
 error_1:
+	if (fd != -1) {
+		close(fd);
+	}
 	sway_log(L_ERROR, "Unable to allocate memory for IPC response");
 	return NULL;
 }
 
 void free_ipc_response(struct ipc_response *response) {
+	if (response->fd != -1) {
+		close(response->fd);
+	}
 	free(response->payload);
 	free(response);
 }
 
-char *ipc_single_command(int socketfd, uint32_t type, const char *payload, uint32_t *len) {
+void ipc_send_command(int socketfd, uint32_t type, const char *payload, uint32_t len) {
 	char data[ipc_header_size];
 	uint32_t *data32 = (uint32_t *)(data + sizeof(ipc_magic));
 	memcpy(data, ipc_magic, sizeof(ipc_magic));
-	data32[0] = *len;
+	data32[0] = len;
 	data32[1] = type;
 
 	if (write(socketfd, data, ipc_header_size) == -1) {
 		sway_abort("Unable to send IPC header");
 	}
 
-	if (write(socketfd, payload, *len) == -1) {
+	if (write(socketfd, payload, len) == -1) {
 		sway_abort("Unable to send IPC payload");
 	}
+}
+
+char *ipc_single_command(int socketfd, uint32_t type, const char *payload, uint32_t *len) {
+	ipc_send_command(socketfd, type, payload, *len);
 
 	struct ipc_response *resp = ipc_recv_response(socketfd);
 	char *response = resp->payload;
 	*len = resp->size;
+	if (resp->fd != -1) {
+		close(resp->fd);
+	}
 	free(resp);
 
 	return response;
@@ -1,7 +1,10 @@
+#define _XOPEN_SOURCE 700
 #include "readline.h"
 #include "log.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <sys/stat.h>
 
 char *read_line(FILE *file) {
 	size_t length = 0, size = 128;
@@ -72,3 +75,72 @@ char *read_line_buffer(FILE *file, char *string, size_t string_len) {
 	string[length] = '\0';
 	return string;
 }
+
+bool line_reader_init(struct line_reader *reader, FILE *file) {
+	reader->data = NULL;
+	reader->length = reader->position = 0;
+	size_t size = 4096;
+	struct stat sb;
+	if (fstat(fileno(file), &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+		// one byte to spare so the last read ends at EOF
+		size = (size_t)sb.st_size + 1;
+	}
+	while (true) {
+		// keep room for the terminator of a last line without newline
+		char *data = realloc(reader->data, size + 1);
+		if (!data) {
+			sway_log(L_ERROR, "Unable to allocate memory for line_reader");
+			free(reader->data);
+			reader->data = NULL;
+			return false;
+		}
+		reader->data = data;
+		reader->length += fread(data + reader->length, 1, size - reader->length, file);
+		if (reader->length < size) {
+			break;
+		}
+		size *= 2;
+	}
+	if (ferror(file)) {
+		sway_log(L_ERROR, "Unable to read file for line_reader");
+		line_reader_finish(reader);
+		return false;
+	}
+	return true;
+}
+
+char *line_reader_next(struct line_reader *reader) {
+	if (!reader->data || reader->position >= reader->length) {
+		return NULL;
+	}
+	// Same rules as read_line, lines only ever get shorter so they are
+	// rewritten where they are
+	char *data = reader->data;
+	char *line = data + reader->position;
+	size_t length = 0;
+	char lastChar = '\0';
+	while (reader->position < reader->length) {
+		char c = data[reader->position++];
+		if (c == '\n' && lastChar == '\\') {
+			--length; // Ignore last character.
+			lastChar = '\0';
+			continue;
+		}
+		if (c == '\n' || c == '\0') {
+			break;
+		}
+		if (c == '\r') {
+			continue;
+		}
+		lastChar = c;
+		line[length++] = c;
+	}
+	line[length] = '\0';
+	return line;
+}
+
+void line_reader_finish(struct line_reader *reader) {
+	free(reader->data);
+	reader->data = NULL;
+	reader->length = reader->position = 0;
+}
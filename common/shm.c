@@ -0,0 +1,75 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/memfd.h>
+#endif
+#include "shm.h"
+
+#if defined(__linux__) && defined(SYS_memfd_create)
+static int create_memfd(const char *name, int *read_fd) {
+	int fd = syscall(SYS_memfd_create, name, MFD_CLOEXEC);
+	if (fd == -1) {
+		return -1;
+	}
+	// reopening gives a descriptor with its own, read-only, access mode
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+	if ((*read_fd = open(path, O_RDONLY | O_CLOEXEC)) == -1) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+#endif
+
+static int create_file(const char *name, int *read_fd) {
+	const char *dir = getenv("XDG_RUNTIME_DIR");
+	if (!dir) {
+		return -1;
+	}
+	size_t length = strlen(dir) + strlen(name) + sizeof("/-XXXXXX");
+	char *path = malloc(length);
+	if (!path) {
+		return -1;
+	}
+	snprintf(path, length, "%s/%s-XXXXXX", dir, name);
+	int fd = mkstemp(path);
+	if (fd == -1) {
+		free(path);
+		return -1;
+	}
+	*read_fd = open(path, O_RDONLY | O_CLOEXEC);
+	unlink(path);
+	free(path);
+	if (*read_fd == -1) {
+		close(fd);
+		return -1;
+	}
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	return fd;
+}
+
+int create_shm_file(const char *name, size_t size, int *read_fd) {
+	int fd = -1;
+#if defined(__linux__) && defined(SYS_memfd_create)
+	fd = create_memfd(name, read_fd);
+#endif
+	if (fd == -1 && (fd = create_file(name, read_fd)) == -1) {
+		return -1;
+	}
+	// the read-only descriptor can still be reopened for writing through
+	// /proc/self/fd, which would let a client truncate the file under our
+	// mappings. Opening checks the mode, descriptors we hold keep working.
+	if (fchmod(fd, 0) == -1 || ftruncate(fd, size) == -1) {
+		close(fd);
+		close(*read_fd);
+		return -1;
+	}
+	return fd;
+}
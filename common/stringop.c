@@ -29,6 +29,16 @@ char *strip_whitespace(char *_str) {
 	return str;
 }
 
+char *strip_whitespace_in_place(char *str) {
+	str += strspn(str, " \t");
+	char *end = strchr(str, '\0');
+	while (end > str && (end[-1] == ' ' || end[-1] == '\t')) {
+		--end;
+	}
+	*end = '\0';
+	return str;
+}
+
 void strip_quotes(char *str) {
 	bool in_str = false;
 	bool in_chr = false;
@@ -91,59 +101,104 @@ void free_flat_list(list_t *list) {
 	list_free(list);
 }
 
-char **split_args(const char *start, int *argc) {
-	*argc = 0;
-	int alloc = 2;
-	char **argv = malloc(sizeof(char *) * alloc);
-	bool in_token = false;
+// Returns the start of the next argument at or after str and sets end past
+// its last character, NULL if there are no more arguments.
+static const char *next_arg(const char *str, const char **_end) {
 	bool in_string = false;
 	bool in_char = false;
 	bool in_brackets = false; // brackets are used for critera
 	bool escaped = false;
+	const char *start = str + strspn(str, whitespace);
 	const char *end = start;
-	if (start) {
-		while (*start) {
-			if (!in_token) {
-				start = (end += strspn(end, whitespace));
-				in_token = true;
-			}
-			if (*end == '"' && !in_char && !escaped) {
-				in_string = !in_string;
-			} else if (*end == '\'' && !in_string && !escaped) {
-				in_char = !in_char;
-			} else if (*end == '[' && !in_string && !in_char && !in_brackets && !escaped) {
-				in_brackets = true;
-			} else if (*end == ']' && !in_string && !in_char && in_brackets && !escaped) {
-				in_brackets = false;
-			} else if (*end == '\\') {
-				escaped = !escaped;
-			} else if (*end == '\0' || (!in_string && !in_char && !in_brackets
-						&& !escaped && strchr(whitespace, *end))) {
-				goto add_token;
-			}
-			if (*end != '\\') {
-				escaped = false;
-			}
-			++end;
-			continue;
-			add_token:
-			if (end - start > 0) {
-				char *token = malloc(end - start + 1);
-				strncpy(token, start, end - start + 1);
-				token[end - start] = '\0';
-				argv[*argc] = token;
-				if (++*argc + 1 == alloc) {
-					argv = realloc(argv, (alloc *= 2) * sizeof(char *));
-				}
-			}
-			in_token = false;
+	if (!*start) {
+		return NULL;
+	}
+	for (; *end; ++end) {
+		if (*end == '"' && !in_char && !escaped) {
+			in_string = !in_string;
+		} else if (*end == '\'' && !in_string && !escaped) {
+			in_char = !in_char;
+		} else if (*end == '[' && !in_string && !in_char && !in_brackets && !escaped) {
+			in_brackets = true;
+		} else if (*end == ']' && !in_string && !in_char && in_brackets && !escaped) {
+			in_brackets = false;
+		} else if (*end == '\\') {
+			escaped = !escaped;
+		} else if (!in_string && !in_char && !in_brackets
+				&& !escaped && strchr(whitespace, *end)) {
+			break;
+		}
+		if (*end != '\\') {
 			escaped = false;
 		}
 	}
+	*_end = end;
+	return start;
+}
+
+char **split_args(const char *str, int *argc) {
+	*argc = 0;
+	int alloc = 2;
+	char **argv = malloc(sizeof(char *) * alloc);
+	const char *start, *end = str;
+	while (end && (start = next_arg(end, &end))) {
+		char *token = malloc(end - start + 1);
+		strncpy(token, start, end - start);
+		token[end - start] = '\0';
+		argv[*argc] = token;
+		if (++*argc + 1 == alloc) {
+			argv = realloc(argv, (alloc *= 2) * sizeof(char *));
+		}
+	}
 	argv[*argc] = NULL;
 	return argv;
 }
 
+char **split_args_buffer(struct split_buffer *buffer, const char *str, int *argc) {
+	*argc = 0;
+	size_t length = strlen(str) + 1;
+	if (length > buffer->size) {
+		char *copy = realloc(buffer->str, length);
+		if (!copy) {
+			return NULL;
+		}
+		buffer->str = copy;
+		buffer->size = length;
+	}
+	memcpy(buffer->str, str, length);
+	char *start, *end = buffer->str;
+	while ((start = (char *)next_arg(end, (const char **)&end))) {
+		if (*argc + 2 > buffer->alloc) {
+			int alloc = buffer->alloc ? buffer->alloc * 2 : 8;
+			char **argv = realloc(buffer->argv, alloc * sizeof(char *));
+			if (!argv) {
+				return NULL;
+			}
+			buffer->argv = argv;
+			buffer->alloc = alloc;
+		}
+		buffer->argv[(*argc)++] = start;
+		if (*end) {
+			*end++ = '\0';
+		}
+	}
+	if (!buffer->argv && !(buffer->argv = malloc(sizeof(char *) * (buffer->alloc = 2)))) {
+		return NULL;
+	}
+	buffer->argv[*argc] = NULL;
+	return buffer->argv;
+}
+
+bool split_buffer_owns(struct split_buffer *buffer, const char *arg) {
+	return arg >= buffer->str && arg < buffer->str + buffer->size;
+}
+
+void split_buffer_finish(struct split_buffer *buffer) {
+	free(buffer->str);
+	free(buffer->argv);
+	memset(buffer, 0, sizeof(*buffer));
+}
+
 void free_argv(int argc, char **argv) {
 	while (argc-- > 0) {
 		free(argv[argc]);
@@ -0,0 +1,20 @@
+#ifndef _SWAY_BENCH_BENCH_H
+#define _SWAY_BENCH_BENCH_H
+#include <stdint.h>
+
+/**
+ * Number of malloc, calloc and realloc calls made by the process so far.
+ * Always 0 where allocations can't be intercepted (non-glibc).
+ */
+unsigned long bench_alloc_count(void);
+
+uint64_t bench_now_ns(void);
+
+/**
+ * Calls fn until at least min_seconds passed and prints the time and the
+ * allocations per operation, fn performs ops_per_call operations each call.
+ */
+void bench_run(const char *name, double min_seconds, unsigned long ops_per_call,
+		void (*fn)(void *data), void *data);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef _SWAY_BENCH_HEADLESS_H
+#define _SWAY_BENCH_HEADLESS_H
+#include <stdbool.h>
+#include <wlc/wlc.h>
+
+/**
+ * Brings up the compositor core on top of the wlc stub, the same way main()
+ * does minus the parts that need a real session (extensions, capabilities,
+ * signal handlers). config is the text of the configuration to load, NULL for
+ * an empty one. Returns false if the configuration could not be loaded.
+ */
+bool headless_init(const char *config);
+
+/**
+ * Creates count outputs of width x height named HEADLESS-1, HEADLESS-2, ...
+ * and stores their handles in outputs, which may be NULL.
+ */
+void headless_create_outputs(int count, uint32_t width, uint32_t height, wlc_handle *outputs);
+
+/**
+ * Runs a command like it was received over IPC and flushes pending layout.
+ * Returns false and logs the error if it failed.
+ */
+bool headless_command(const char *command);
+
+#endif
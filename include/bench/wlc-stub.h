@@ -0,0 +1,64 @@
+#ifndef _SWAY_BENCH_WLC_STUB_H
+#define _SWAY_BENCH_WLC_STUB_H
+#include <stdbool.h>
+#include <sys/types.h>
+#include <wlc/wlc.h>
+
+/**
+ * In-process replacement for the parts of wlc sway uses. Outputs and views
+ * only exist as handles with some state attached, nothing is rendered and no
+ * seat is opened. The callbacks registered with wlc_set_*_cb are invoked by
+ * the functions below the same way wlc would invoke them for real clients.
+ */
+
+/**
+ * Counters of the calls the compositor made into wlc, to check how much work
+ * an operation caused.
+ */
+struct wlc_stub_stats {
+	unsigned long view_set_geometry;
+	unsigned long view_set_mask;
+	unsigned long pixels_write;
+	unsigned long schedule_render;
+	unsigned long frames;
+};
+
+struct wlc_stub_stats *wlc_stub_get_stats(void);
+void wlc_stub_reset_stats(void);
+
+/**
+ * Runs the compositor ready callback, wlc does this from wlc_run.
+ */
+void wlc_stub_ready(void);
+
+wlc_handle wlc_stub_output_create(const char *name, uint32_t width, uint32_t height);
+void wlc_stub_output_destroy(wlc_handle output);
+
+/**
+ * Maps a new view on output. Any of the strings may be NULL. Returns 0 if the
+ * compositor refused the view.
+ */
+wlc_handle wlc_stub_view_create(wlc_handle output, const char *title,
+		const char *app_id, const char *class, const char *instance, pid_t pid);
+void wlc_stub_view_destroy(wlc_handle view);
+void wlc_stub_view_set_title(wlc_handle view, const char *title);
+void wlc_stub_view_set_type(wlc_handle view, uint32_t type);
+
+bool wlc_stub_key(uint32_t key, uint32_t modifiers, enum wlc_key_state state);
+bool wlc_stub_button(uint32_t button, uint32_t modifiers, enum wlc_button_state state);
+bool wlc_stub_pointer_motion(double x, double y);
+
+/**
+ * Renders a frame on every output that scheduled one, running the pre and
+ * post render callbacks.
+ */
+void wlc_stub_render(void);
+
+/**
+ * Dispatches event sources that are ready within timeout milliseconds (-1
+ * blocks) and finishes views that were asked to close. Returns the number of
+ * dispatched sources.
+ */
+int wlc_stub_dispatch(int timeout);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef _SWAY_HASHMAP_H
+#define _SWAY_HASHMAP_H
+#include <stdbool.h>
+#include <stdint.h>
+
+struct hashmap_entry {
+	const void *key;
+	void *value;
+	uint32_t hash;
+	bool used;
+};
+
+// Open addressing hash table. Keys are not owned by the map, the caller must
+// keep them alive for as long as they are stored.
+typedef struct {
+	int capacity;
+	int length;
+	struct hashmap_entry *entries;
+	uint32_t (*hash)(const void *key);
+	int (*compare)(const void *key, const void *cmp_to);
+} hashmap_t;
+
+// Creates a map using the given hash and compare functions. compare must
+// return 0 when both keys are equal (see strcmp).
+hashmap_t *create_hashmap(uint32_t hash(const void *key),
+		int compare(const void *key, const void *cmp_to));
+void hashmap_free(hashmap_t *map);
+// Returns the value stored for key, or NULL if there is none.
+void *hashmap_get(hashmap_t *map, const void *key);
+// Stores value for key, replacing the one stored before. Returns false if key
+// is new and the table is full and couldn't grow, the map is unchanged then.
+bool hashmap_set(hashmap_t *map, const void *key, void *value);
+// Removes key from the map and returns its value, or NULL.
+void *hashmap_del(hashmap_t *map, const void *key);
+// Removes every entry, keeping the allocated table around.
+void hashmap_clear(hashmap_t *map);
+// The callback must not modify the map.
+void hashmap_foreach(hashmap_t *map,
+		void (*callback)(const void *key, void *value, void *data), void *data);
+
+// Hash and compare functions for keys that are plain integers or pointers
+// (wlc_handle, pid_t, ...) cast to void *.
+uint32_t hash_ptr(const void *key);
+int compare_ptr(const void *key, const void *cmp_to);
+// Hash and compare functions for NUL terminated string keys.
+uint32_t hash_string(const void *key);
+int compare_string(const void *key, const void *cmp_to);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef _SWAY_INTERN_H
+#define _SWAY_INTERN_H
+#include <stddef.h>
+
+/**
+ * Reference counted table of shared, immutable strings. Interning the same
+ * contents twice returns the same pointer, so interned strings can be
+ * compared with ==.
+ */
+
+/**
+ * Returns the interned copy of str with a new reference, NULL if str is NULL
+ * or out of memory.
+ */
+const char *intern_string(const char *str);
+/**
+ * Takes another reference to an interned string (or NULL).
+ */
+const char *intern_ref(const char *str);
+/**
+ * Drops a reference taken by intern_string or intern_ref, the string is freed
+ * with the last one. NULL is ignored.
+ */
+void intern_release(const char *str);
+
+struct intern_stats {
+	size_t strings; // distinct strings in the table
+	size_t references; // references held on them
+	size_t bytes; // heap used by the strings and the table
+	size_t saved; // bytes a separate copy per reference would take in addition
+};
+
+const struct intern_stats *get_intern_stats(void);
+
+#endif
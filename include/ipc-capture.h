@@ -0,0 +1,33 @@
+#ifndef _SWAY_IPC_CAPTURE_H
+#define _SWAY_IPC_CAPTURE_H
+#include <stdint.h>
+
+/**
+ * Continuous capture of an output area, see IPC_SWAY_CAPTURE.
+ *
+ * The client sends { "output", "x", "y", "w", "h", "buffers" } like for
+ * get_pixels, the area is clipped to the output and n may be lowered to keep
+ * the buffers within 256 MB. The reply is { "success": true, "buffers": n,
+ * "buffer_size": size } along with the descriptor of a shared memory file
+ * holding n buffers of size bytes each. After every frame sway rendered on the
+ * output it reads the area into a free buffer and sends an IPC_EVENT_CAPTURE
+ * event whose payload is a struct ipc_capture_frame. The buffer then belongs to the
+ * client until it sends { "release": buffer }. Frames rendered while every
+ * buffer is taken are skipped and counted. { "stop": true } ends the capture.
+ */
+
+struct ipc_capture_frame {
+	// counts the frames sent, starting at 0
+	uint32_t sequence;
+	// buffer index, the pixels are at buffer * buffer_size in the file
+	uint32_t buffer;
+	// RGBA, bottom row first like get_pixels
+	uint32_t width, height;
+	// frames skipped since the previous one because no buffer was free
+	uint32_t skipped;
+	uint32_t reserved;
+	// CLOCK_MONOTONIC time the frame was rendered at, in nanoseconds
+	uint64_t time;
+};
+
+#endif
@@ -7,12 +7,14 @@
 
 /**
  * IPC response including type of IPC response, size of payload and the json
- * encoded payload string.
+ * encoded payload string. fd is a descriptor sent along with the response
+ * (e.g. for IPC_SWAY_GET_TREE_SNAPSHOT) or -1.
  */
 struct ipc_response {
 	uint32_t size;
 	uint32_t type;
 	char *payload;
+	int fd;
 };
 
 /**
@@ -23,6 +25,10 @@ char *get_socketpath(void);
  * Opens the sway socket.
  */
 int ipc_open_socket(const char *socket_path);
+/**
+ * Sends a single IPC command without waiting for the response.
+ */
+void ipc_send_command(int socketfd, uint32_t type, const char *payload, uint32_t len);
 /**
  * Issues a single IPC command and returns the buffer. len will be updated with
  * the length of the buffer returned from sway.
@@ -0,0 +1,96 @@
+#ifndef _SWAY_IPC_SNAPSHOT_H
+#define _SWAY_IPC_SNAPSHOT_H
+#include <stdint.h>
+
+/**
+ * Layout of the shared memory tree snapshot handed out by
+ * IPC_SWAY_GET_TREE_SNAPSHOT. The file starts with struct ipc_snapshot_header,
+ * which points at the current struct ipc_snapshot_tree. A tree is followed by
+ * its nodes and then by its string pool, all offsets are relative to the start
+ * of the tree and all integers are in host byte order.
+ *
+ * sway never modifies a published tree, it writes the next one elsewhere in
+ * the file and then switches offset while sequence is odd. Readers sample
+ * like this:
+ *
+ *   do {
+ *       seq = __atomic_load_n(&header->sequence, __ATOMIC_ACQUIRE);
+ *       if (seq & 1) continue;
+ *       if (header->size > mapped_size) remap;
+ *       tree = (void *)header + header->offset;
+ *       ... read what you need ...
+ *       __atomic_thread_fence(__ATOMIC_ACQUIRE);
+ *   } while (__atomic_load_n(&header->sequence, __ATOMIC_RELAXED) != seq);
+ *
+ * Anything read before the sequence check may be garbage and must not be
+ * followed without bounds checks.
+ */
+
+#define IPC_SNAPSHOT_MAGIC 0x73777473 // "stws"
+#define IPC_SNAPSHOT_VERSION 1
+
+enum ipc_snapshot_flags {
+	// sway stopped updating the file, request a new one
+	IPC_SNAPSHOT_STALE = 1,
+};
+
+struct ipc_snapshot_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t sequence;
+	uint32_t flags;
+	// size of the file, it only grows
+	uint64_t size;
+	// offset of the current tree from the start of the file
+	uint64_t offset;
+};
+
+enum ipc_snapshot_node_type {
+	IPC_SNAPSHOT_ROOT,
+	IPC_SNAPSHOT_OUTPUT,
+	IPC_SNAPSHOT_WORKSPACE,
+	IPC_SNAPSHOT_CONTAINER,
+	IPC_SNAPSHOT_VIEW,
+};
+
+enum ipc_snapshot_node_flags {
+	IPC_SNAPSHOT_VISIBLE = 1,
+	IPC_SNAPSHOT_FLOATING = 2,
+	// the focused child of its parent
+	IPC_SNAPSHOT_FOCUSED = 4,
+	IPC_SNAPSHOT_FULLSCREEN = 8,
+	IPC_SNAPSHOT_STICKY = 16,
+};
+
+// string offset of absent strings
+#define IPC_SNAPSHOT_NO_STRING UINT32_MAX
+
+struct ipc_snapshot_tree {
+	// see IPC_SWAY_GET_TREE_GENERATION
+	uint64_t generation;
+	// bytes of the tree including nodes and strings
+	uint32_t length;
+	uint32_t node_count;
+	// node index of the focused container, -1 if there is none
+	int32_t focused;
+	// offset of the string pool, strings are NUL terminated and shared
+	// between nodes
+	uint32_t strings;
+};
+
+/**
+ * Nodes come in get_tree order, parents before their children and tiled
+ * children before floating ones. Rects are in output coordinates like in
+ * get_tree.
+ */
+struct ipc_snapshot_node {
+	uint64_t id;
+	// node index of the parent, -1 for the root
+	int32_t parent;
+	uint32_t type;
+	int32_t x, y, width, height;
+	uint32_t flags;
+	uint32_t name, class, app_id;
+};
+
+#endif
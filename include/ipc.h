@@ -23,7 +23,13 @@ enum ipc_command_type {
 	IPC_EVENT_BINDING = ((1<<31) | 5),
 	IPC_EVENT_MODIFIER = ((1<<31) | 6),
 	IPC_EVENT_INPUT = ((1<<31) | 7),
-	IPC_SWAY_GET_PIXELS = 0x81
+	IPC_EVENT_TREE = ((1<<31) | 8),
+	IPC_EVENT_CAPTURE = ((1<<31) | 9),
+	IPC_SWAY_GET_PIXELS = 0x81,
+	IPC_SWAY_GET_TREE_GENERATION = 0x82,
+	IPC_SWAY_GET_TREE_SNAPSHOT = 0x83,
+	IPC_SWAY_GET_CONTAINERS = 0x84,
+	IPC_SWAY_CAPTURE = 0x85
 };
 
 #endif
@@ -1,9 +1,30 @@
 #ifndef _SWAY_READLINE_H
 #define _SWAY_READLINE_H
 
+#include <stdbool.h>
 #include <stdio.h>
 
 char *read_line(FILE *file);
 char *read_line_buffer(FILE *file, char *string, size_t string_len);
 
+/**
+ * Reads a whole file into one buffer and hands out its lines in place, with
+ * the same rules as read_line. Lines stay valid until line_reader_finish.
+ */
+struct line_reader {
+	char *data;
+	size_t length;
+	size_t position;
+};
+
+/**
+ * Reads the rest of file. Returns false and logs the error if it couldn't.
+ */
+bool line_reader_init(struct line_reader *reader, FILE *file);
+/**
+ * Returns the next line, NULL at the end of the file.
+ */
+char *line_reader_next(struct line_reader *reader);
+void line_reader_finish(struct line_reader *reader);
+
 #endif
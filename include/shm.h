@@ -0,0 +1,15 @@
+#ifndef _SWAY_SHM_H
+#define _SWAY_SHM_H
+#include <stddef.h>
+
+/**
+ * Creates an anonymous shared memory file of size bytes (a memfd where
+ * available) and returns a read-write descriptor of it, or -1. read_fd is set
+ * to a read-only descriptor of the same file to hand to other processes. The
+ * file has mode 0, so that they cannot reopen it for writing or truncating
+ * through /proc/self/fd either, short of running as root. Both are
+ * close-on-exec.
+ */
+int create_shm_file(const char *name, size_t size, int *read_fd);
+
+#endif
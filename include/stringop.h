@@ -1,5 +1,7 @@
 #ifndef _SWAY_STRINGOP_H
 #define _SWAY_STRINGOP_H
+#include <stdbool.h>
+#include <stddef.h>
 #include "list.h"
 
 #if !HAVE_DECL_SETENV
@@ -11,6 +13,8 @@ extern int setenv(const char *, const char *, int);
 extern const char whitespace[];
 
 char *strip_whitespace(char *str);
+// Like strip_whitespace, but doesn't reallocate str
+char *strip_whitespace_in_place(char *str);
 char *strip_comments(char *str);
 void strip_quotes(char *str);
 
@@ -25,6 +29,29 @@ void free_flat_list(list_t *list);
 char **split_args(const char *str, int *argc);
 void free_argv(int argc, char **argv);
 
+/**
+ * Storage reused by split_args_buffer across calls, zero it before the first.
+ */
+struct split_buffer {
+	char *str;
+	size_t size;
+	char **argv;
+	int alloc;
+};
+
+/**
+ * Splits a copy of str like split_args, into buffer instead of one allocation
+ * per argument. The arguments stay valid until the next call or
+ * split_buffer_finish. Returns NULL if out of memory.
+ */
+char **split_args_buffer(struct split_buffer *buffer, const char *str, int *argc);
+/**
+ * Returns true if arg points into the copy made by split_args_buffer, false
+ * if a caller replaced it with a string of its own.
+ */
+bool split_buffer_owns(struct split_buffer *buffer, const char *arg);
+void split_buffer_finish(struct split_buffer *buffer);
+
 char *code_strchr(const char *string, char delimiter);
 char *code_strstr(const char *haystack, const char *needle);
 int unescape_string(char *string);
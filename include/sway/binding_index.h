@@ -0,0 +1,48 @@
+#ifndef _SWAY_BINDING_INDEX_H
+#define _SWAY_BINDING_INDEX_H
+#include <stdbool.h>
+#include <stdint.h>
+#include "config.h"
+
+/**
+ * The bindings of a mode compiled into a table keyed on modifiers and
+ * key/button, so finding the binding of an input event doesn't depend on the
+ * number of bindings. Each bucket keeps the order of mode->bindings, which
+ * gives the same precedence as scanning the list.
+ */
+struct binding_index;
+
+/**
+ * Compiles the bindings of mode. Done for every mode after loading the
+ * config, lookups build the index on demand if it is missing.
+ */
+bool binding_index_build(struct sway_mode *mode);
+
+/**
+ * Drops the index of mode, needed whenever mode->bindings changes.
+ */
+void binding_index_invalidate(struct sway_mode *mode);
+
+void binding_index_free(struct binding_index *index);
+
+/**
+ * Returns the first binding of mode for modifiers that contains the pressed
+ * key and whose keys are all held down, or NULL.
+ */
+struct sway_binding *binding_index_key_pressed(struct sway_mode *mode,
+		uint32_t modifiers, uint32_t keysym, uint32_t keycode);
+
+/**
+ * Returns the first single key release binding of mode for modifiers matching
+ * the key released last, or NULL.
+ */
+struct sway_binding *binding_index_key_released(struct sway_mode *mode, uint32_t modifiers);
+
+/**
+ * Returns the first (release) binding of mode for modifiers containing
+ * button, or NULL.
+ */
+struct sway_binding *binding_index_button(struct sway_mode *mode,
+		uint32_t modifiers, uint32_t button, bool released);
+
+#endif
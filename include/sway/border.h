@@ -1,18 +1,45 @@
 #ifndef _SWAY_BORDER_H
 #define _SWAY_BORDER_H
+#include <stdint.h>
 #include <wlc/wlc.h>
 #include "container.h"
 
+enum border_strip_position {
+	BORDER_TOP,	/**< Everything above the view, including title bars */
+	BORDER_BOTTOM,
+	BORDER_LEFT,
+	BORDER_RIGHT,
+	// Keep last
+	BORDER_STRIPS,
+};
+
 /**
- * Border pixel buffer and corresponding geometry.
+ * Part of a border pixel buffer and its geometry.
  */
-struct border {
+struct border_strip {
 	unsigned char *buffer;
 	struct wlc_geometry geometry;
 };
 
 /**
- * Clear border buffer.
+ * Border pixel buffers and corresponding geometry.
+ *
+ * The area covered by the view itself is never drawn to, so only the strips
+ * around it are allocated and uploaded.
+ */
+struct border {
+	struct border_strip strips[BORDER_STRIPS];
+	struct wlc_geometry geometry;
+	/**
+	 * The visual state the buffers were rendered for, see border_key in
+	 * border.c. key_length is 0 if they are not valid.
+	 */
+	unsigned char *key;
+	size_t key_length;
+};
+
+/**
+ * Clear border buffer. This also invalidates the cached rendering.
  */
 void border_clear(struct border *border);
 
@@ -4,6 +4,7 @@
 #include <json-c/json.h>
 #include <wlc/wlc.h>
 #include "config.h"
+#include "stringop.h"
 
 // Container that a called command should act upon. Only valid in command functions.
 extern swayc_t *current_container;
@@ -61,13 +62,14 @@ struct cmd_results *handle_command(char *command, enum command_context context);
 /**
  * Parse and handles a command during config file loading.
  *
- * Do not use this under normal conditions.
+ * Do not use this under normal conditions. args holds the arguments between
+ * calls, the caller frees it with split_buffer_finish.
  */
-struct cmd_results *config_command(char *command, enum cmd_status block);
+struct cmd_results *config_command(char *command, enum cmd_status block, struct split_buffer *args);
 /*
  * Parses a command policy rule.
  */
-struct cmd_results *config_commands_command(char *exec);
+struct cmd_results *config_commands_command(char *exec, struct split_buffer *args);
 
 /**
  * Allocates a cmd_results object.
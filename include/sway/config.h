@@ -42,12 +42,16 @@ struct sway_mouse_binding {
 	char *command;
 };
 
+struct binding_index;
+struct criteria_index;
+
 /**
  * A "mode" of keybindings created via the `mode` command.
  */
 struct sway_mode {
 	char *name;
 	list_t *bindings;
+	struct binding_index *binding_index;
 };
 
 /**
@@ -236,9 +240,11 @@ enum ipc_feature {
 	IPC_FEATURE_EVENT_BINDING = 4096,
 	IPC_FEATURE_EVENT_INPUT = 8192,
 	IPC_FEATURE_GET_CLIPBOARD = 16384,
+	IPC_FEATURE_EVENT_TREE = 32768,
+	IPC_FEATURE_CAPTURE = 65536,
 
-	IPC_FEATURE_ALL_COMMANDS = 1 | 2 | 4 | 8 | 16 | 32 | 64 | 128 | 16384,
-	IPC_FEATURE_ALL_EVENTS = 256 | 512 | 1024 | 2048 | 4096 | 8192,
+	IPC_FEATURE_ALL_COMMANDS = 1 | 2 | 4 | 8 | 16 | 32 | 64 | 128 | 16384 | 65536,
+	IPC_FEATURE_ALL_EVENTS = 256 | 512 | 1024 | 2048 | 4096 | 8192 | 32768,
 
 	IPC_FEATURE_ALL = IPC_FEATURE_ALL_COMMANDS | IPC_FEATURE_ALL_EVENTS,
 };
@@ -262,6 +268,8 @@ struct sway_config {
 	list_t *input_configs;
 	list_t *criteria;
 	list_t *no_focus;
+	struct criteria_index *criteria_index;
+	struct criteria_index *no_focus_index;
 	list_t *active_bar_modifiers;
 	struct sway_mode *current_mode;
 	struct bar_config *current_bar;
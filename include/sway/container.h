@@ -8,6 +8,8 @@
 
 typedef struct sway_container swayc_t;
 
+struct hit_index;
+
 extern swayc_t root_container;
 extern swayc_t *current_focus;
 
@@ -57,6 +59,36 @@ enum swayc_border_types {
 	B_NORMAL	/**< Normal border with title bar */
 };
 
+/**
+ * Everything arrange_windows_r reads to lay out a container, besides the
+ * structure of its subtree. If none of it changed and the subtree is not
+ * marked dirty, the previous layout is still valid.
+ */
+struct layout_input {
+	double x, y, width, height;
+	double ws_x, ws_y, ws_width, ws_height;
+	double output_width, output_height;
+	enum swayc_layouts layout, parent_layout;
+	enum swayc_border_types border_type;
+	int border_thickness;
+	int gap;
+	int index, siblings, workspace_children;
+	size_t nb_master, nb_slave_groups;
+	int font_height;
+	int hide_edge_borders;
+	bool edge_gaps, smart_gaps;
+	bool fullscreen, tabbed_stacked;
+};
+
+struct layout_cache {
+	struct layout_input input;
+	/**
+	 * The size the last layout pass left the container with.
+	 */
+	double width, height;
+	bool valid;
+};
+
 /**
  * Stores information about a container.
  *
@@ -111,12 +143,27 @@ struct sway_container {
 	bool is_floating;
 	bool is_focused;
 	bool sticky; // floating view always visible on its output
+	/**
+	 * True while this container is queued by schedule_arrange_windows.
+	 */
+	bool arrange_pending;
+	/**
+	 * Set when the children of this container or any of its descendants
+	 * changed, see mark_layout_dirty.
+	 */
+	bool layout_dirty;
+	struct layout_cache layout_cache;
+	/**
+	 * Pointer hit testing index of workspaces, see hit_index.h.
+	 */
+	struct hit_index *hit_index;
 
-	// Attributes that mostly views have.
+	// Attributes that mostly views have. The name of a view and the class,
+	// instance and app_id are interned, see intern.h.
 	char *name;
-	char *class;
-	char *instance;
-	char *app_id;
+	const char *class;
+	const char *instance;
+	const char *app_id;
 
 	// Used by output containers to keep track of swaybg child processes.
 	pid_t bg_pid;
@@ -167,7 +214,7 @@ struct sway_container {
 	size_t nb_slave_groups;
 
 	/**
-	 * Marks applied to the container, list_t of char*.
+	 * Marks applied to the container, list_t of interned char*.
 	 */
 	list_t *marks;
 };
@@ -248,8 +295,24 @@ swayc_t *swayc_focus_by_layout(swayc_t *container, enum swayc_layouts);
 
 /**
  * Gets the swayc_t associated with a wlc_handle.
+ *
+ * This is a hash lookup; only outputs and views that are attached to the tree
+ * are found (views hidden in the scratchpad are not).
  */
 swayc_t *swayc_by_handle(wlc_handle handle);
+/**
+ * Adds an output or view to the handle index used by swayc_by_handle.
+ *
+ * new_output, new_view and new_floating_view do this already; it is only
+ * needed when a container is put back into the tree after being detached with
+ * swayc_unindex_handle. Can be used with container_map.
+ */
+void swayc_index_handle(swayc_t *container, void *data);
+/**
+ * Removes an output or view from the handle index. Used when containers are
+ * detached from the tree without being destroyed (e.g. the scratchpad).
+ */
+void swayc_unindex_handle(swayc_t *container, void *data);
 /**
  * Gets the named swayc_t.
  */
@@ -287,6 +350,11 @@ bool swayc_is_active(swayc_t *view);
  * Returns true if the parent is an ancestor of the child.
  */
 bool swayc_is_parent_of(swayc_t *parent, swayc_t *child);
+/**
+ * Returns true if the container is attached to the root, i.e. not a hidden
+ * scratchpad view.
+ */
+bool swayc_in_tree(swayc_t *container);
 /**
  * Returns true if the child is a desecendant of the parent.
  */
@@ -321,6 +389,10 @@ int swayc_gap(swayc_t *container);
  * Maps a container's children over a function.
  */
 void container_map(swayc_t *, void (*f)(swayc_t *, void *), void *);
+/**
+ * Sorts containers in the order container_map visits them.
+ */
+void container_sort_tree_order(list_t *containers);
 
 /**
  * Set a view as visible or invisible.
@@ -343,6 +415,14 @@ void add_gaps(swayc_t *view, void *amount);
  */
 void update_visibility(swayc_t *container);
 
+/**
+ * Counter bumped by every change of the tree that is visible through IPC
+ * queries: structure, geometry, focus, titles, marks and anything a command
+ * changed. Two equal values mean the replies didn't change.
+ */
+uint64_t get_tree_generation(void);
+void bump_tree_generation(void);
+
 /**
  * Close all child views of container
  */
@@ -22,12 +22,26 @@ struct criteria {
 	char *cmdlist;
 };
 
+/**
+ * Compiled form of a list of criteria for criteria_for and criteria_any.
+ */
+struct criteria_index;
+
 int criteria_cmp(const void *item, const void *data);
 void free_criteria(struct criteria *crit);
 
 // Pouplate list with crit_tokens extracted from criteria string, returns error
 // string or NULL if successful.
 char *extract_crit_tokens(list_t *tokens, const char *criteria);
+// Frees the list and the crit_tokens in it.
+void free_crit_tokens(list_t *tokens);
+
+// Compiles criteria into *index, replacing the previous one. Matching builds
+// the index on demand, this only moves the work to config load. Returns false
+// if out of memory, matching then tests every criteria.
+bool criteria_index_build(struct criteria_index **index, list_t *criteria);
+// Frees *index after the criteria it was built from changed.
+void criteria_index_invalidate(struct criteria_index **index);
 
 // Returns list of criteria that match given container. These criteria have
 // been set with `for_window` commands and have an associated cmdlist.
@@ -36,7 +50,8 @@ list_t *criteria_for(swayc_t *cont);
 // Returns a list of all containers that match the given list of tokens.
 list_t *container_for(list_t *tokens);
 
-// Returns true if any criteria in the given list matches this container
-bool criteria_any(swayc_t *cont, list_t *criteria);
+// Returns true if any criteria in the given list matches this container. index
+// caches the compiled criteria between calls.
+bool criteria_any(swayc_t *cont, list_t *criteria, struct criteria_index **index);
 
 #endif
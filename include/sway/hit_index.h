@@ -0,0 +1,43 @@
+#ifndef _SWAY_HIT_INDEX_H
+#define _SWAY_HIT_INDEX_H
+#include <stdbool.h>
+#include "container.h"
+
+/**
+ * Per workspace grid over the rectangles pointer events are tested against:
+ * the tiled containers reachable from the workspace, its floating views and
+ * all title bars. It is rebuilt lazily on the first lookup after the
+ * workspace was invalidated.
+ */
+struct hit_index;
+
+/**
+ * Marks the index of the workspace containing container as stale. Called
+ * whenever geometry, structure or focus inside a workspace changes.
+ */
+void hit_index_invalidate(swayc_t *container);
+
+void hit_index_free(struct hit_index *index);
+
+/**
+ * Finds the container the pointer at x, y (output coordinates) is over, with
+ * the same rules container_under_pointer uses from workspace downwards: the
+ * topmost visible floating view, else the deepest tiled container, following
+ * the focus of tabbed/stacked containers. result is set to the workspace if
+ * the point is not over any of its children.
+ *
+ * Returns false if the index can't answer, e.g. for points outside of the
+ * output, the caller has to fall back to walking the tree.
+ */
+bool hit_index_container_at(swayc_t *workspace, double x, double y, swayc_t **result);
+
+/**
+ * Finds the first container with a normal border whose title bar contains
+ * x, y, in the order container_find walks the workspace. result is set to
+ * NULL if there is none.
+ *
+ * Returns false if the index can't answer.
+ */
+bool hit_index_title_bar_at(swayc_t *workspace, double x, double y, swayc_t **result);
+
+#endif
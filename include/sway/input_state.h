@@ -12,6 +12,9 @@ bool check_key(uint32_t key_sym, uint32_t key_code);
 // returns true if key_sym matches latest released key.
 bool check_released_key(uint32_t key_sym);
 
+// gets the key sym and alternative key sym of the latest released key.
+void get_released_key(uint32_t *key_sym, uint32_t *alt_sym);
+
 // sets a key as pressed
 void press_key(uint32_t key_sym, uint32_t key_code);
 
@@ -1,6 +1,8 @@
 #ifndef _SWAY_IPC_JSON_H
 #define _SWAY_IPC_JSON_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <json-c/json.h>
 #include "config.h"
 #include "container.h"
@@ -12,4 +14,44 @@ json_object *ipc_json_describe_container_recursive(swayc_t *c);
 json_object *ipc_json_describe_window(swayc_t *c);
 json_object *ipc_json_describe_input(struct libinput_device *device);
 
+const char *ipc_json_layout_description(enum swayc_layouts l);
+const char *ipc_json_border_description(enum swayc_border_types border_type);
+/**
+ * The "layout" get_tree reports for c, NULL where it reports null. Views and
+ * containers report the layout of their parent.
+ */
+const char *ipc_json_container_layout(swayc_t *c);
+
+/**
+ * Output buffer of the streaming serializers, which write the same text as
+ * json_object_to_json_string does for the matching json_object functions.
+ * error is set if the buffer couldn't grow, the content is incomplete then.
+ */
+struct ipc_json_buffer {
+	char *data;
+	size_t length;
+	size_t size;
+	bool error;
+};
+
+/**
+ * Starts buf with reserved bytes left for the caller (e.g. a message header).
+ */
+void ipc_json_buffer_init(struct ipc_json_buffer *buf, size_t reserved);
+/**
+ * Appends ipc_json_describe_container_recursive(c).
+ */
+void ipc_json_write_tree(struct ipc_json_buffer *buf, swayc_t *c);
+/**
+ * Appends the get_workspaces reply.
+ */
+void ipc_json_write_workspaces(struct ipc_json_buffer *buf);
+/**
+ * Appends an array of ipc_json_describe_container for each of containers,
+ * with only the keys in fields (in the order get_tree has them). Unknown keys
+ * are left out, all keys are included if fields is NULL.
+ */
+void ipc_json_write_containers(struct ipc_json_buffer *buf, list_t *containers,
+		const char **fields, int count);
+
 #endif
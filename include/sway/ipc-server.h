@@ -31,11 +31,25 @@ void ipc_event_modifier(uint32_t modifier, const char *state);
  * Send IPC keyboard binding event.
  */
 void ipc_event_binding_keyboard(struct sway_binding *sb);
+/**
+ * Schedules a tree event describing what changed since the last one and an
+ * update of the shared tree snapshot. Called whenever the tree generation
+ * changes, does nothing if neither is in use.
+ */
+void ipc_event_tree_changed(void);
+/**
+ * Sends the scheduled tree event right away.
+ */
+void ipc_event_tree_flush(void);
 const char *swayc_type_string(enum swayc_types type);
 
 /**
  * Send pixel data to registered clients.
  */
 void ipc_get_pixels(wlc_handle output);
+/**
+ * Sends the frame just rendered on output to clients capturing it.
+ */
+void ipc_capture_frames(wlc_handle output);
 
 #endif
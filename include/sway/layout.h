@@ -61,6 +61,39 @@ void update_geometry(swayc_t *view);
 void arrange_windows(swayc_t *container, double width, double height);
 void arrange_backgrounds(void);
 
+/**
+ * Marks container and its ancestors to be laid out again by the next arrange,
+ * even if their geometry stays the same. Changes to the geometry, layout,
+ * gaps or borders are detected without this, but structural changes (adding,
+ * removing or reordering children) are not.
+ */
+void mark_layout_dirty(swayc_t *container);
+
+/**
+ * Queues container to be arranged by the next flush_arrange_windows. Requests
+ * for containers that are already covered by a queued ancestor are merged, so
+ * N requests during one event loop iteration result in at most one layout
+ * pass per affected subtree.
+ */
+void schedule_arrange_windows(swayc_t *container);
+/**
+ * Arranges every container queued by schedule_arrange_windows. Called before
+ * rendering and before the tree geometry is reported over IPC.
+ */
+void flush_arrange_windows(void);
+/**
+ * Drops container from the arrange queue, used when it is destroyed.
+ */
+void cancel_arrange_windows(swayc_t *container);
+
+struct arrange_stats {
+	unsigned long requests; // calls to schedule_arrange_windows
+	unsigned long flushes; // flushes that had pending work
+	unsigned long arranged; // layout passes actually performed
+};
+
+const struct arrange_stats *get_arrange_stats(void);
+
 swayc_t *get_focused_container(swayc_t *parent);
 swayc_t *get_swayc_in_direction(swayc_t *container, enum movement_direction dir);
 swayc_t *get_swayc_in_direction_under(swayc_t *container, enum movement_direction dir, swayc_t *limit);
@@ -0,0 +1,33 @@
+#ifndef _SWAY_MARK_INDEX_H
+#define _SWAY_MARK_INDEX_H
+#include <stdbool.h>
+#include "container.h"
+
+/**
+ * Marks are unique, each belongs to at most one container. These functions
+ * are the only ones changing swayc_t.marks, they keep a global map from mark
+ * to container up to date.
+ */
+
+/**
+ * Adds mark to container, taking it from the container that had it.
+ */
+void container_add_mark(swayc_t *container, const char *mark);
+/**
+ * Removes mark from container. Returns false if the container didn't have it.
+ */
+bool container_remove_mark(swayc_t *container, const char *mark);
+void container_clear_marks(swayc_t *container);
+bool container_has_mark(swayc_t *container, const char *mark);
+
+/**
+ * Returns the container with mark, or NULL.
+ */
+swayc_t *mark_index_find(const char *mark);
+/**
+ * Calls f for every mark and the container that has it, in no particular
+ * order. f must not add or remove marks.
+ */
+void mark_index_foreach(void (*f)(const char *mark, swayc_t *container, void *data), void *data);
+
+#endif
@@ -4,6 +4,18 @@
 #include "sway/config.h"
 
 uint32_t get_feature_policy_mask(pid_t pid);
+
+/**
+ * Resolves the feature policy of a process once and keeps it around for
+ * get_feature_policy_mask. Every call must be paired with a call to
+ * uncache_feature_policy_mask, normally when the view is created/destroyed.
+ */
+void cache_feature_policy_mask(pid_t pid);
+void uncache_feature_policy_mask(pid_t pid);
+/**
+ * Resolves cached policies against the current config again.
+ */
+void invalidate_feature_policy_cache(void);
 uint32_t get_ipc_policy_mask(pid_t pid);
 uint32_t get_command_policy_mask(const char *cmd);
 
@@ -0,0 +1,38 @@
+#ifndef _SWAY_TREE_DIFF_H
+#define _SWAY_TREE_DIFF_H
+#include <json-c/json.h>
+#include "container.h"
+
+/**
+ * Shadow copy of the parts of the tree IPC clients mirror, used to describe
+ * what changed since the last update as a list of patches keyed by container
+ * id.
+ */
+struct tree_diff;
+
+/**
+ * Takes a snapshot of the current tree.
+ */
+struct tree_diff *tree_diff_create(void);
+void tree_diff_free(struct tree_diff *diff);
+
+/**
+ * Compares the tree with the snapshot and moves the snapshot forward. Returns
+ * a json array of patches in the order they have to be applied, or NULL if
+ * nothing changed:
+ *
+ *   { "op": "add", "id", "parent", "list", "index", "node" }
+ *   { "op": "remove", "id" }
+ *   { "op": "move", "id", "parent", "list", "index" }
+ *   { "op": "geometry", "id", "rect" }
+ *   { "op": "properties", "id", "name", "layout", "border", "visible",
+ *     "floating", "sticky", "fullscreen_mode" }
+ *   { "op": "focus", "id" }
+ *
+ * list is "nodes" or "floating_nodes" and node is the container as get_tree
+ * describes it, without children. Every patch carries absolute values, so
+ * applying one twice is harmless.
+ */
+json_object *tree_diff_update(struct tree_diff *diff);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef _SWAY_TREE_SNAPSHOT_H
+#define _SWAY_TREE_SNAPSHOT_H
+#include <stdbool.h>
+
+/**
+ * Shared memory copy of the tree for clients sampling it often, see
+ * ipc-snapshot.h for the layout.
+ */
+struct tree_snapshot;
+
+/**
+ * Creates the shared memory file and publishes the current tree.
+ */
+struct tree_snapshot *tree_snapshot_create(void);
+/**
+ * Marks the file stale for readers still mapping it and frees the snapshot.
+ */
+void tree_snapshot_free(struct tree_snapshot *snapshot);
+/**
+ * Publishes the current tree unless the published one is up to date.
+ */
+bool tree_snapshot_update(struct tree_snapshot *snapshot);
+/**
+ * Returns a new read-only descriptor of the file, owned by the caller, or -1.
+ */
+int tree_snapshot_get_fd(struct tree_snapshot *snapshot);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef _SWAY_VIEW_INDEX_H
+#define _SWAY_VIEW_INDEX_H
+#include <stdbool.h>
+#include <stddef.h>
+#include "container.h"
+#include "list.h"
+
+/**
+ * Every view by con_id and by its class, instance and app_id, whether it is
+ * in the tree or in the scratchpad. Views are added once their attributes
+ * are set and removed when they are freed, wlc doesn't change the attributes
+ * of a mapped view.
+ */
+enum view_attribute {
+	VIEW_CLASS,
+	VIEW_INSTANCE,
+	VIEW_APP_ID,
+	VIEW_ATTRIBUTE_COUNT
+};
+
+void view_index_add(swayc_t *view);
+void view_index_remove(swayc_t *view);
+
+/**
+ * Returns the view with the given con_id, or NULL.
+ */
+swayc_t *view_index_by_id(size_t id);
+
+/**
+ * Adds the views whose attribute equals value (or starts with it, if prefix)
+ * to views, in no particular order.
+ */
+void view_index_find(list_t *views, enum view_attribute attribute,
+		const char *value, bool prefix);
+
+#endif
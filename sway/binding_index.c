@@ -0,0 +1,219 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "sway/binding_index.h"
+#include "sway/config.h"
+#include "sway/input_state.h"
+#include "hashmap.h"
+#include "list.h"
+#include "log.h"
+
+enum binding_kind {
+	BINDING_KEY_SYM,
+	BINDING_KEY_CODE,
+	BINDING_KEY_RELEASE,
+	BINDING_BUTTON,
+	BINDING_BUTTON_RELEASE,
+};
+
+struct binding_key {
+	enum binding_kind kind;
+	uint32_t modifiers;
+	uint32_t key;
+};
+
+struct binding_ref {
+	// index in mode->bindings, buckets are sorted by it
+	int position;
+	struct sway_binding *binding;
+};
+
+struct binding_bucket {
+	struct binding_key key;
+	struct binding_ref *refs;
+	int length, capacity;
+};
+
+struct binding_index {
+	hashmap_t *buckets;
+};
+
+static uint32_t hash_binding_key(const void *_key) {
+	const struct binding_key *key = _key;
+	uint64_t h = ((uint64_t)key->modifiers << 35) ^ ((uint64_t)key->kind << 32) ^ key->key;
+	h *= 0x9E3779B97F4A7C15ull;
+	return (uint32_t)(h >> 32);
+}
+
+static int compare_binding_key(const void *_a, const void *_b) {
+	const struct binding_key *a = _a, *b = _b;
+	return a->kind != b->kind || a->modifiers != b->modifiers || a->key != b->key;
+}
+
+static void free_bucket(const void *key, void *value, void *data) {
+	struct binding_bucket *bucket = value;
+	free(bucket->refs);
+	free(bucket);
+}
+
+void binding_index_free(struct binding_index *index) {
+	if (!index) {
+		return;
+	}
+	if (index->buckets) {
+		hashmap_foreach(index->buckets, free_bucket, NULL);
+		hashmap_free(index->buckets);
+	}
+	free(index);
+}
+
+void binding_index_invalidate(struct sway_mode *mode) {
+	binding_index_free(mode->binding_index);
+	mode->binding_index = NULL;
+}
+
+static bool add_ref(struct binding_index *index, enum binding_kind kind,
+		struct sway_binding *binding, int position, uint32_t key) {
+	struct binding_key lookup = { kind, binding->modifiers, key };
+	struct binding_bucket *bucket = hashmap_get(index->buckets, &lookup);
+	if (!bucket) {
+		if (!(bucket = calloc(1, sizeof(struct binding_bucket)))) {
+			return false;
+		}
+		bucket->key = lookup;
+		if (!hashmap_set(index->buckets, &bucket->key, bucket)) {
+			free(bucket);
+			return false;
+		}
+	}
+	// a binding listing the same key twice only needs one entry
+	if (bucket->length && bucket->refs[bucket->length - 1].binding == binding) {
+		return true;
+	}
+	if (bucket->length == bucket->capacity) {
+		int capacity = bucket->capacity ? bucket->capacity * 2 : 2;
+		struct binding_ref *refs = realloc(bucket->refs, capacity * sizeof(struct binding_ref));
+		if (!refs) {
+			return false;
+		}
+		bucket->refs = refs;
+		bucket->capacity = capacity;
+	}
+	bucket->refs[bucket->length++] = (struct binding_ref){ position, binding };
+	return true;
+}
+
+static bool add_binding(struct binding_index *index, struct sway_binding *binding, int position) {
+	for (int i = 0; i < binding->keys->length; ++i) {
+		uint32_t key = *(uint32_t *)binding->keys->items[i];
+		enum binding_kind kind;
+		if (binding->release) {
+			// only single key bindings trigger on release
+			if (binding->keys->length == 1
+					&& !add_ref(index, BINDING_KEY_RELEASE, binding, position, key)) {
+				return false;
+			}
+			kind = BINDING_BUTTON_RELEASE;
+		} else {
+			if (!add_ref(index, binding->bindcode ? BINDING_KEY_CODE : BINDING_KEY_SYM,
+						binding, position, key)) {
+				return false;
+			}
+			kind = BINDING_BUTTON;
+		}
+		// buttons are matched against key syms
+		if (!binding->bindcode && !add_ref(index, kind, binding, position, key)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool binding_index_build(struct sway_mode *mode) {
+	binding_index_invalidate(mode);
+	struct binding_index *index = calloc(1, sizeof(struct binding_index));
+	if (!index || !(index->buckets = create_hashmap(hash_binding_key, compare_binding_key))) {
+		sway_log(L_ERROR, "Unable to allocate binding index for mode %s", mode->name);
+		free(index);
+		return false;
+	}
+	for (int i = 0; i < mode->bindings->length; ++i) {
+		if (!add_binding(index, mode->bindings->items[i], i)) {
+			sway_log(L_ERROR, "Unable to build binding index for mode %s", mode->name);
+			binding_index_free(index);
+			return false;
+		}
+	}
+	sway_log(L_DEBUG, "Compiled %d bindings of mode %s into %d buckets",
+			mode->bindings->length, mode->name, index->buckets->length);
+	mode->binding_index = index;
+	return true;
+}
+
+static struct binding_bucket *get_bucket(struct sway_mode *mode,
+		enum binding_kind kind, uint32_t modifiers, uint32_t key) {
+	if (!mode->binding_index && !binding_index_build(mode)) {
+		return NULL;
+	}
+	struct binding_key lookup = { kind, modifiers, key };
+	return hashmap_get(mode->binding_index->buckets, &lookup);
+}
+
+static bool binding_keys_pressed(struct sway_binding *binding) {
+	for (int i = 0; i < binding->keys->length; ++i) {
+		uint32_t key = *(uint32_t *)binding->keys->items[i];
+		if (binding->bindcode ? !check_key(0, key) : !check_key(key, 0)) {
+			return false;
+		}
+	}
+	return binding->keys->length > 0;
+}
+
+/**
+ * Returns the first binding of both buckets, in mode->bindings order, that
+ * satisfies accept (if given).
+ */
+static struct sway_binding *first_binding(struct binding_bucket *a, struct binding_bucket *b,
+		bool (*accept)(struct sway_binding *binding)) {
+	int i = 0, j = 0;
+	int a_length = a ? a->length : 0, b_length = b ? b->length : 0;
+	while (i < a_length || j < b_length) {
+		struct binding_ref *ref;
+		if (j >= b_length || (i < a_length && a->refs[i].position < b->refs[j].position)) {
+			ref = &a->refs[i++];
+		} else {
+			ref = &b->refs[j++];
+		}
+		if (!accept || accept(ref->binding)) {
+			return ref->binding;
+		}
+	}
+	return NULL;
+}
+
+struct sway_binding *binding_index_key_pressed(struct sway_mode *mode,
+		uint32_t modifiers, uint32_t keysym, uint32_t keycode) {
+	struct binding_bucket *syms = get_bucket(mode, BINDING_KEY_SYM, modifiers, keysym);
+	struct binding_bucket *codes = get_bucket(mode, BINDING_KEY_CODE, modifiers, keycode);
+	return first_binding(syms, codes, binding_keys_pressed);
+}
+
+struct sway_binding *binding_index_key_released(struct sway_mode *mode, uint32_t modifiers) {
+	uint32_t key_sym, alt_sym;
+	get_released_key(&key_sym, &alt_sym);
+	struct binding_bucket *a = NULL, *b = NULL;
+	if (key_sym != 0) {
+		a = get_bucket(mode, BINDING_KEY_RELEASE, modifiers, key_sym);
+	}
+	if (alt_sym != 0 && alt_sym != key_sym) {
+		b = get_bucket(mode, BINDING_KEY_RELEASE, modifiers, alt_sym);
+	}
+	return first_binding(a, b, NULL);
+}
+
+struct sway_binding *binding_index_button(struct sway_mode *mode,
+		uint32_t modifiers, uint32_t button, bool released) {
+	struct binding_bucket *bucket = get_bucket(mode,
+			released ? BINDING_BUTTON_RELEASE : BINDING_BUTTON, modifiers, button);
+	return first_binding(bucket, NULL, NULL);
+}
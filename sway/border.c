@@ -23,43 +23,109 @@ void cairo_set_source_u32(cairo_t *cairo, uint32_t color) {
 }
 
 void border_clear(struct border *border) {
-	if (border && border->buffer) {
-		free(border->buffer);
-		border->buffer = NULL;
+	if (!border) {
+		return;
+	}
+	for (int i = 0; i < BORDER_STRIPS; ++i) {
+		free(border->strips[i].buffer);
+		border->strips[i].buffer = NULL;
+	}
+	free(border->key);
+	border->key = NULL;
+	border->key_length = 0;
+}
+
+/**
+ * Splits the border geometry into the strips around the view geometry.
+ */
+static void set_border_strips(struct border *border, const struct wlc_geometry *v) {
+	const struct wlc_geometry *g = &border->geometry;
+	int left = g->origin.x, right = g->origin.x + (int)g->size.w;
+	int top = g->origin.y, bottom = g->origin.y + (int)g->size.h;
+
+	// the part of the view inside of the border geometry
+	int vleft = MIN(MAX(v->origin.x, left), right);
+	int vright = MIN(MAX(v->origin.x + (int)v->size.w, vleft), right);
+	int vtop = MIN(MAX(v->origin.y, top), bottom);
+	int vbottom = MIN(MAX(v->origin.y + (int)v->size.h, vtop), bottom);
+	if (vleft == vright || vtop == vbottom) {
+		vleft = vright = left;
+		vtop = vbottom = bottom;
+	}
+
+	struct wlc_geometry strips[BORDER_STRIPS] = {
+		[BORDER_TOP] = {
+			.origin = { .x = left, .y = top },
+			.size = { .w = right - left, .h = vtop - top }
+		},
+		[BORDER_BOTTOM] = {
+			.origin = { .x = left, .y = vbottom },
+			.size = { .w = right - left, .h = bottom - vbottom }
+		},
+		[BORDER_LEFT] = {
+			.origin = { .x = left, .y = vtop },
+			.size = { .w = vleft - left, .h = vbottom - vtop }
+		},
+		[BORDER_RIGHT] = {
+			.origin = { .x = vright, .y = vtop },
+			.size = { .w = right - vright, .h = vbottom - vtop }
+		},
+	};
+	for (int i = 0; i < BORDER_STRIPS; ++i) {
+		border->strips[i].geometry = strips[i];
 	}
 }
 
-static cairo_t *create_border_buffer(swayc_t *view, struct wlc_geometry g, cairo_surface_t **surface) {
+static bool create_border_buffers(swayc_t *view, struct wlc_geometry g) {
 	if (view->border == NULL) {
-		view->border = malloc(sizeof(struct border));
+		view->border = calloc(1, sizeof(struct border));
 		if (!view->border) {
 			sway_log(L_ERROR, "Unable to allocate window border information");
-			return NULL;
+			return false;
 		}
 	}
-	cairo_t *cr;
-	int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, g.size.w);
-	view->border->buffer = calloc(stride * g.size.h, sizeof(unsigned char));
 	view->border->geometry = g;
-	if (!view->border->buffer) {
-		sway_log(L_ERROR, "Unable to allocate window border buffer");
-		return NULL;
+	set_border_strips(view->border, &view->actual_geometry);
+	for (int i = 0; i < BORDER_STRIPS; ++i) {
+		struct border_strip *strip = &view->border->strips[i];
+		if (strip->geometry.size.w == 0 || strip->geometry.size.h == 0) {
+			continue;
+		}
+		int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, strip->geometry.size.w);
+		strip->buffer = calloc(stride * strip->geometry.size.h, sizeof(unsigned char));
+		if (!strip->buffer) {
+			border_clear(view->border);
+			sway_log(L_ERROR, "Unable to allocate window border buffer");
+			return false;
+		}
 	}
-	*surface = cairo_image_surface_create_for_data(view->border->buffer,
-			CAIRO_FORMAT_ARGB32, g.size.w, g.size.h, stride);
+	return true;
+}
+
+/**
+ * Creates a cairo context for one of the border strips. Its coordinates are
+ * relative to the whole border geometry, so everything can be drawn as if the
+ * border was one buffer.
+ */
+static cairo_t *create_strip_context(struct border *border, struct border_strip *strip,
+		cairo_surface_t **surface) {
+	struct wlc_geometry *g = &strip->geometry;
+	int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, g->size.w);
+	*surface = cairo_image_surface_create_for_data(strip->buffer,
+			CAIRO_FORMAT_ARGB32, g->size.w, g->size.h, stride);
 	if (cairo_surface_status(*surface) != CAIRO_STATUS_SUCCESS) {
-		border_clear(view->border);
 		sway_log(L_ERROR, "Unable to allocate window border surface");
 		return NULL;
 	}
-	cr = cairo_create(*surface);
+	cairo_t *cr = cairo_create(*surface);
 	cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
 	if (cairo_status(cr) != CAIRO_STATUS_SUCCESS) {
 		cairo_surface_destroy(*surface);
-		border_clear(view->border);
 		sway_log(L_ERROR, "Unable to create cairo context");
 		return NULL;
 	}
+	cairo_translate(cr, border->geometry.origin.x - g->origin.x,
+			border->geometry.origin.y - g->origin.y);
 	return cr;
 }
 
@@ -177,6 +243,13 @@ static void render_title_bar(swayc_t *view, cairo_t *cr, struct wlc_geometry *b,
 	int x = MIN(tb->origin.x, tb->origin.x - b->origin.x);
 	int y = MIN(tb->origin.y, tb->origin.y - b->origin.y);
 
+	// skip the text layout if this title bar is not on the strip being drawn
+	double x1, y1, x2, y2;
+	cairo_clip_extents(cr, &x1, &y1, &x2, &y2);
+	if (x >= x2 || y >= y2 || x + (int)tb->size.w <= x1 || y + (int)tb->size.h <= y1) {
+		return;
+	}
+
 	// title bar background
 	cairo_set_source_u32(cr, colors->background);
 	cairo_rectangle(cr, x, y, tb->size.w, tb->size.h);
@@ -318,34 +391,161 @@ static char *generate_container_title(swayc_t *container) {
 	return container->name + 6; // don't include "sway: "
 }
 
-void update_tabbed_stacked_titlebars(swayc_t *c, cairo_t *cr, struct wlc_geometry *g, swayc_t *focused, swayc_t *focused_inactive) {
+static struct border_colors *tabbed_stacked_title_colors(swayc_t *c,
+		swayc_t *focused, swayc_t *focused_inactive) {
 	if (c->type == C_CONTAINER) {
 		if (c->parent->focused == c) {
-			render_title_bar(c, cr, g, &config->border_colors.focused_inactive);
-		} else {
-			render_title_bar(c, cr, g, &config->border_colors.unfocused);
+			return &config->border_colors.focused_inactive;
 		}
+		return &config->border_colors.unfocused;
+	}
 
-		if (!c->visible) {
-			return;
-		}
+	bool is_child_of_focused = swayc_is_child_of(c, get_focused_container(&root_container));
+
+	if (focused == c || is_child_of_focused) {
+		return &config->border_colors.focused;
+	} else if (focused_inactive == c) {
+		return &config->border_colors.focused_inactive;
+	}
+	return &config->border_colors.unfocused;
+}
+
+void update_tabbed_stacked_titlebars(swayc_t *c, cairo_t *cr, struct wlc_geometry *g, swayc_t *focused, swayc_t *focused_inactive) {
+	render_title_bar(c, cr, g, tabbed_stacked_title_colors(c, focused, focused_inactive));
 
+	if (c->type == C_CONTAINER && c->visible) {
 		int i;
 		for (i = 0; i < c->children->length; ++i) {
 			swayc_t *child = c->children->items[i];
 			update_tabbed_stacked_titlebars(child, cr, g, focused, focused_inactive);
 		}
-	} else {
-		bool is_child_of_focused = swayc_is_child_of(c, get_focused_container(&root_container));
+	}
+}
 
-		if (focused == c || is_child_of_focused) {
-			render_title_bar(c, cr, g, &config->border_colors.focused);
-		} else if (focused_inactive == c) {
-			render_title_bar(c, cr, g, &config->border_colors.focused_inactive);
-		} else {
-			render_title_bar(c, cr, g, &config->border_colors.unfocused);
+static struct border_colors *view_border_colors(swayc_t *view, swayc_t *p,
+		swayc_t *focused, swayc_t *focused_inactive, bool is_child_of_focused) {
+	if (view == focused || is_child_of_focused) {
+		return &config->border_colors.focused;
+	} else if (p || focused_inactive == view) {
+		return &config->border_colors.focused_inactive;
+	}
+	return &config->border_colors.unfocused;
+}
+
+static void render_view_border(swayc_t *view, cairo_t *cr, swayc_t *p,
+		struct border_colors *colors, swayc_t *focused, swayc_t *focused_inactive) {
+	// for tabbed/stacked layouts the focused view has to draw all the
+	// titlebars of the hidden views.
+	if (p) {
+		render_borders(view, cr, colors, !should_hide_top_border(view, view->y));
+		update_tabbed_stacked_titlebars(p, cr, &view->border->geometry, focused, focused_inactive);
+		return;
+	}
+
+	switch (view->border_type) {
+	case B_NONE:
+		break;
+	case B_PIXEL:
+		render_borders(view, cr, colors, true);
+		break;
+	case B_NORMAL:
+		render_borders(view, cr, colors, false);
+		render_title_bar(view, cr, &view->border_geometry, colors);
+		break;
+	}
+}
+
+/**
+ * The border key holds everything that ends up in the border buffers:
+ * geometry, border type, colors, font, titles and marks. Buffers are only
+ * rasterized again when it changes. It is compared in full rather than by a
+ * hash, a collision would keep showing a stale border.
+ */
+struct border_key {
+	unsigned char *data;
+	size_t length, size;
+	bool error;
+};
+
+static void border_key_add(struct border_key *key, const void *data, size_t len) {
+	if (key->error) {
+		return;
+	}
+	if (key->size - key->length < len) {
+		size_t size = key->size ? key->size : 256;
+		while (size - key->length < len) {
+			size *= 2;
+		}
+		unsigned char *grown = realloc(key->data, size);
+		if (!grown) {
+			key->error = true;
+			return;
 		}
+		key->data = grown;
+		key->size = size;
 	}
+	memcpy(key->data + key->length, data, len);
+	key->length += len;
+}
+
+static void border_key_add_str(struct border_key *key, const char *str) {
+	// include the terminator so that adjacent strings can't run together
+	border_key_add(key, str ? str : "", str ? strlen(str) + 1 : 1);
+}
+
+static void border_key_add_title_bar(struct border_key *key, swayc_t *c, struct border_colors *colors) {
+	border_key_add(key, colors, sizeof(*colors));
+	border_key_add(key, &c->title_bar_geometry, sizeof(c->title_bar_geometry));
+	border_key_add(key, &c->actual_geometry, sizeof(c->actual_geometry));
+	border_key_add(key, &c->parent->layout, sizeof(c->parent->layout));
+	border_key_add_str(key, c->name);
+	if (config->show_marks && c->marks) {
+		for (int i = 0; i < c->marks->length; ++i) {
+			border_key_add_str(key, c->marks->items[i]);
+		}
+	}
+}
+
+static void border_key_add_tabbed_stacked(struct border_key *key, swayc_t *c,
+		swayc_t *focused, swayc_t *focused_inactive) {
+	border_key_add_title_bar(key, c, tabbed_stacked_title_colors(c, focused, focused_inactive));
+
+	if (c->type == C_CONTAINER && c->visible) {
+		for (int i = 0; i < c->children->length; ++i) {
+			border_key_add_tabbed_stacked(key, c->children->items[i], focused, focused_inactive);
+		}
+	}
+}
+
+/**
+ * Returns the key of the border of view, which stays valid until the next call,
+ * or NULL if out of memory.
+ */
+static struct border_key *border_key(swayc_t *view, swayc_t *p, struct wlc_geometry *g,
+		struct border_colors *colors, swayc_t *focused, swayc_t *focused_inactive) {
+	// reused, most keys are built only to find the border unchanged
+	static struct border_key key = { 0 };
+	key.length = 0;
+	key.error = false;
+	bool is_only_child = view->parent->children && view->parent->children->length == 1;
+
+	border_key_add(&key, g, sizeof(*g));
+	border_key_add(&key, &view->border_geometry, sizeof(view->border_geometry));
+	border_key_add(&key, &view->border_type, sizeof(view->border_type));
+	border_key_add(&key, &view->is_floating, sizeof(view->is_floating));
+	border_key_add(&key, &is_only_child, sizeof(is_only_child));
+	border_key_add(&key, &config->show_marks, sizeof(config->show_marks));
+	border_key_add_str(&key, config->font);
+
+	if (p) {
+		bool render_top = !should_hide_top_border(view, view->y);
+		border_key_add(&key, &render_top, sizeof(render_top));
+		border_key_add(&key, colors, sizeof(*colors));
+		border_key_add_tabbed_stacked(&key, p, focused, focused_inactive);
+	} else {
+		border_key_add_title_bar(&key, view, colors);
+	}
+	return key.error ? NULL : &key;
 }
 
 static void update_view_border(swayc_t *view) {
@@ -353,12 +553,6 @@ static void update_view_border(swayc_t *view) {
 		return;
 	}
 
-	cairo_t *cr = NULL;
-	cairo_surface_t *surface = NULL;
-
-	// clear previous border buffer.
-	border_clear(view->border);
-
 	// get focused and focused_inactive views
 	swayc_t *focused = get_focused_view(&root_container);
 	swayc_t *container = swayc_parent_by_type(view, C_CONTAINER);
@@ -375,31 +569,13 @@ static void update_view_border(swayc_t *view) {
 		}
 	}
 
-	// for tabbed/stacked layouts the focused view has to draw all the
-	// titlebars of the hidden views.
+	struct wlc_geometry g = view->border_geometry;
 	swayc_t *p = NULL;
 	if (view->parent->focused == view && (p = swayc_tabbed_stacked_ancestor(view))) {
-		struct wlc_geometry g = {
-			.origin = {
-				.x = p->x,
-				.y = p->y
-			},
-			.size = {
-				.w = p->width,
-				.h = p->height
-			}
-		};
-		cr = create_border_buffer(view, g, &surface);
-		if (!cr) {
-			goto cleanup;
-		}
-
-		bool render_top = !should_hide_top_border(view, view->y);
-		if (view == focused || is_child_of_focused) {
-			render_borders(view, cr, &config->border_colors.focused, render_top);
-		} else {
-			render_borders(view, cr, &config->border_colors.focused_inactive, render_top);
-		}
+		g.origin.x = p->x;
+		g.origin.y = p->y;
+		g.size.w = p->width;
+		g.size.h = p->height;
 
 		// generate container titles
 		int i;
@@ -409,61 +585,49 @@ static void update_view_border(swayc_t *view) {
 				generate_container_title(child);
 			}
 		}
+	} else if (view->border_type == B_NONE) {
+		border_clear(view->border);
+		return;
+	}
 
-		update_tabbed_stacked_titlebars(p, cr, &g, focused, focused_inactive);
-	} else {
-		switch (view->border_type) {
-		case B_NONE:
-			break;
-		case B_PIXEL:
-			cr = create_border_buffer(view, view->border_geometry, &surface);
-			if (!cr) {
-				break;
-			}
-
-			if (focused == view || is_child_of_focused) {
-				render_borders(view, cr, &config->border_colors.focused, true);
-			} else if (focused_inactive == view) {
-				render_borders(view, cr, &config->border_colors.focused_inactive, true);
-			} else {
-				render_borders(view, cr, &config->border_colors.unfocused, true);
-			}
+	struct border_colors *colors = view_border_colors(view, p,
+			focused, focused_inactive, is_child_of_focused);
+	struct border_key *key = border_key(view, p, &g, colors, focused, focused_inactive);
+	if (key && view->border && view->border->key_length == key->length
+			&& memcmp(view->border->key, key->data, key->length) == 0) {
+		// nothing visible changed since the last time, reuse the buffers
+		return;
+	}
 
-			break;
-		case B_NORMAL:
-			cr = create_border_buffer(view, view->border_geometry, &surface);
-			if (!cr) {
-				break;
-			}
+	// clear previous border buffer.
+	border_clear(view->border);
 
-			if (focused == view || is_child_of_focused) {
-				render_borders(view, cr, &config->border_colors.focused, false);
-				render_title_bar(view, cr, &view->border_geometry,
-					&config->border_colors.focused);
-			} else if (focused_inactive == view) {
-				render_borders(view, cr, &config->border_colors.focused_inactive, false);
-				render_title_bar(view, cr, &view->border_geometry,
-					&config->border_colors.focused_inactive);
-			} else {
-				render_borders(view, cr, &config->border_colors.unfocused, false);
-				render_title_bar(view, cr, &view->border_geometry,
-					&config->border_colors.unfocused);
-			}
+	if (!create_border_buffers(view, g)) {
+		return;
+	}
 
-			break;
+	for (int i = 0; i < BORDER_STRIPS; ++i) {
+		struct border_strip *strip = &view->border->strips[i];
+		if (!strip->buffer) {
+			continue;
+		}
+		cairo_surface_t *surface = NULL;
+		cairo_t *cr = create_strip_context(view->border, strip, &surface);
+		if (!cr) {
+			border_clear(view->border);
+			return;
 		}
-	}
 
-cleanup:
+		render_view_border(view, cr, p, colors, focused, focused_inactive);
 
-	if (surface) {
 		cairo_surface_flush(surface);
 		cairo_surface_destroy(surface);
-	}
-
-	if (cr) {
 		cairo_destroy(cr);
 	}
+	if (key && (view->border->key = malloc(key->length))) {
+		memcpy(view->border->key, key->data, key->length);
+		view->border->key_length = key->length;
+	}
 }
 
 void update_container_border(swayc_t *container) {
@@ -490,8 +654,14 @@ void render_view_borders(wlc_handle view) {
 		return;
 	}
 
-	if (c->border && c->border->buffer) {
-		wlc_pixels_write(WLC_RGBA8888, &c->border->geometry, c->border->buffer);
+	if (!c->border) {
+		return;
+	}
+	for (int i = 0; i < BORDER_STRIPS; ++i) {
+		struct border_strip *strip = &c->border->strips[i];
+		if (strip->buffer) {
+			wlc_pixels_write(WLC_RGBA8888, &strip->geometry, strip->buffer);
+		}
 	}
 }
 
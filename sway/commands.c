@@ -93,6 +93,7 @@ void hide_view_in_scratchpad(swayc_t *sp_view) {
 	sp_view->visible = false;
 	swayc_t *ws = sp_view->parent;
 	remove_child(sp_view);
+	container_map(sp_view, swayc_unindex_handle, NULL);
 	if (swayc_active_workspace() != ws && ws->floating->length == 0 && ws->children->length == 0) {
 		destroy_workspace(ws);
 	} else {
@@ -313,6 +314,7 @@ static struct cmd_handler bar_colors_handlers[] = {
 static struct cmd_handler ipc_handlers[] = {
 	{ "*", cmd_ipc_cmd },
 	{ "bar-config", cmd_ipc_cmd },
+	{ "capture", cmd_ipc_cmd },
 	{ "command", cmd_ipc_cmd },
 	{ "events", cmd_ipc_events },
 	{ "inputs", cmd_ipc_cmd },
@@ -328,6 +330,7 @@ static struct cmd_handler ipc_event_handlers[] = {
 	{ "input", cmd_ipc_event_cmd },
 	{ "mode", cmd_ipc_event_cmd },
 	{ "output", cmd_ipc_event_cmd },
+	{ "tree", cmd_ipc_event_cmd },
 	{ "window", cmd_ipc_event_cmd },
 	{ "workspace", cmd_ipc_event_cmd },
 };
@@ -469,6 +472,9 @@ struct cmd_results *handle_command(char *_exec, enum command_context context) {
 				sway_log(L_INFO, "Running on container '%s'", current_container->name);
 
 				struct cmd_results *res = handler->handle(argc-1, argv+1);
+				// marks, sticky, names etc. are changed without any
+				// notification the generation would otherwise pick up
+				bump_tree_generation();
 				if (res->status != CMD_SUCCESS) {
 					free_argv(argc, argv);
 					if (results) {
@@ -481,6 +487,9 @@ struct cmd_results *handle_command(char *_exec, enum command_context context) {
 				++i;
 			} while(containers && i < containers->length);
 
+			// the next command must see the layout this one asked for,
+			// e.g. the size of a container that was just moved
+			flush_arrange_windows();
 			free_argv(argc, argv);
 		} while(cmdlist);
 
@@ -507,10 +516,13 @@ struct cmd_results *handle_command(char *_exec, enum command_context context) {
 //	  be chained together)
 // 4) handle_command handles all state internally while config_command has some
 //	  state handled outside (notably the block mode, in read_config)
-struct cmd_results *config_command(char *exec, enum cmd_status block) {
+struct cmd_results *config_command(char *exec, enum cmd_status block, struct split_buffer *args) {
 	struct cmd_results *results = NULL;
 	int argc;
-	char **argv = split_args(exec, &argc);
+	char **argv = split_args_buffer(args, exec, &argc);
+	if (!argv) {
+		return cmd_results_new(CMD_FAILURE, NULL, "Unable to allocate arguments");
+	}
 	if (!argc) {
 		results = cmd_results_new(CMD_SUCCESS, NULL, NULL);
 		goto cleanup;
@@ -529,9 +541,15 @@ struct cmd_results *config_command(char *exec, enum cmd_status block) {
 		goto cleanup;
 	}
 	int i;
-	// Var replacement, for all but first argument of set
+	// Var replacement, for all but first argument of set. Arguments point into
+	// args, only the ones with a variable get a copy to replace it in.
 	for (i = handler->handle == cmd_set ? 2 : 1; i < argc; ++i) {
-		argv[i] = do_var_replacement(argv[i]);
+		if (strchr(argv[i], '$')) {
+			char *copy = strdup(argv[i]);
+			if (copy) {
+				argv[i] = do_var_replacement(copy);
+			}
+		}
 		unescape_string(argv[i]);
 	}
 	/* Strip quotes for first argument.
@@ -546,14 +564,22 @@ struct cmd_results *config_command(char *exec, enum cmd_status block) {
 	}
 
 cleanup:
-	free_argv(argc, argv);
+	// Free the copies, along with anything a handler put in their place
+	for (i = 0; i < argc; ++i) {
+		if (!split_buffer_owns(args, argv[i])) {
+			free(argv[i]);
+		}
+	}
 	return results;
 }
 
-struct cmd_results *config_commands_command(char *exec) {
+struct cmd_results *config_commands_command(char *exec, struct split_buffer *args) {
 	struct cmd_results *results = NULL;
 	int argc;
-	char **argv = split_args(exec, &argc);
+	char **argv = split_args_buffer(args, exec, &argc);
+	if (!argv) {
+		return cmd_results_new(CMD_FAILURE, NULL, "Unable to allocate arguments");
+	}
 	if (!argc) {
 		results = cmd_results_new(CMD_SUCCESS, NULL, NULL);
 		goto cleanup;
@@ -625,7 +651,6 @@ struct cmd_results *config_commands_command(char *exec) {
 	results = cmd_results_new(CMD_SUCCESS, NULL, NULL);
 
 cleanup:
-	free_argv(argc, argv);
 	return results;
 }
 
@@ -52,6 +52,7 @@ struct cmd_results *cmd_assign(int argc, char **argv) {
 	} else {
 		sway_log(L_DEBUG, "assign: '%s' -> '%s' added", crit->crit_raw, crit->cmdlist);
 		list_add(config->criteria, crit);
+		criteria_index_invalidate(&config->criteria_index);
 	}
 	return error ? error : cmd_results_new(CMD_SUCCESS, NULL, NULL);
 }
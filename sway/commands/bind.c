@@ -4,6 +4,7 @@
 #include "sway/commands.h"
 #include "sway/config.h"
 #include "sway/input_state.h"
+#include "sway/binding_index.h"
 #include "list.h"
 #include "log.h"
 #include "stringop.h"
@@ -90,6 +91,7 @@ struct cmd_results *cmd_bindsym(int argc, char **argv) {
 	binding->order = binding_order++;
 	list_add(mode->bindings, binding);
 	list_qsort(mode->bindings, sway_binding_cmp_qsort);
+	binding_index_invalidate(mode);
 
 	sway_log(L_DEBUG, "bindsym - Bound %s to command %s", argv[0], binding->command);
 	return cmd_results_new(CMD_SUCCESS, NULL, NULL);
@@ -164,6 +166,7 @@ struct cmd_results *cmd_bindcode(int argc, char **argv) {
 	binding->order = binding_order++;
 	list_add(mode->bindings, binding);
 	list_qsort(mode->bindings, sway_binding_cmp_qsort);
+	binding_index_invalidate(mode);
 
 	sway_log(L_DEBUG, "bindcode - Bound %s to command %s", argv[0], binding->command);
 	return cmd_results_new(CMD_SUCCESS, NULL, NULL);
@@ -72,6 +72,8 @@ struct cmd_results *cmd_floating(int argc, char **argv) {
 		}
 		// Refocus on the view once its been put back into the layout
 		view->width = view->height = 0;
+		// the window event and the rest of the command chain read the
+		// geometry, it can't wait for the next frame
 		arrange_windows(swayc_active_workspace(), -1, -1);
 		remove_view_from_scratchpad(view);
 		ipc_event_window(view, "floating");
@@ -36,6 +36,7 @@ struct cmd_results *cmd_for_window(int argc, char **argv) {
 	} else {
 		sway_log(L_DEBUG, "for_window: '%s' -> '%s' added", crit->crit_raw, crit->cmdlist);
 		list_add(config->criteria, crit);
+		criteria_index_invalidate(&config->criteria_index);
 	}
 	return error ? error : cmd_results_new(CMD_SUCCESS, NULL, NULL);
 }
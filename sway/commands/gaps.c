@@ -25,7 +25,7 @@ struct cmd_results *cmd_gaps(int argc, char **argv) {
 			return cmd_results_new(CMD_INVALID, "gaps", "Number is out out of range.");
 		}
 		config->gaps_inner = config->gaps_outer = amount;
-		arrange_windows(&root_container, -1, -1);
+		schedule_arrange_windows(&root_container);
 		return cmd_results_new(CMD_SUCCESS, NULL, NULL);
 	}
 	// gaps inner|outer n
@@ -41,7 +41,7 @@ struct cmd_results *cmd_gaps(int argc, char **argv) {
 		} else if (strcasecmp(target_str, "outer") == 0) {
 			config->gaps_outer = amount;
 		}
-		arrange_windows(&root_container, -1, -1);
+		schedule_arrange_windows(&root_container);
 		return cmd_results_new(CMD_SUCCESS, NULL, NULL);
 	} else if (argc == 2 && strcasecmp(argv[0], "edge_gaps") == 0) {
 		// gaps edge_gaps <on|off|toggle>
@@ -55,7 +55,7 @@ struct cmd_results *cmd_gaps(int argc, char **argv) {
 			config->edge_gaps =
 				(strcasecmp(argv[1], "yes") == 0 || strcasecmp(argv[1], "on") == 0);
 		}
-		arrange_windows(&root_container, -1, -1);
+		schedule_arrange_windows(&root_container);
 		return cmd_results_new(CMD_SUCCESS, NULL, NULL);
 	}
 	// gaps inner|outer current|all set|plus|minus n
@@ -130,7 +130,7 @@ struct cmd_results *cmd_gaps(int argc, char **argv) {
 		} else if ((cont->gaps += amount) < 0) {
 			cont->gaps = 0;
 		}
-		arrange_windows(cont->parent, -1, -1);
+		schedule_arrange_windows(cont->parent);
 	} else if (inout == OUTER) {
 		//resize all workspace.
 		int i,j;
@@ -145,7 +145,7 @@ struct cmd_results *cmd_gaps(int argc, char **argv) {
 				}
 			}
 		}
-		arrange_windows(&root_container, -1, -1);
+		schedule_arrange_windows(&root_container);
 	} else {
 		// Resize gaps for all views in workspace
 		swayc_t *top;
@@ -159,7 +159,7 @@ struct cmd_results *cmd_gaps(int argc, char **argv) {
 		int top_gap = top->gaps;
 		container_map(top, method == SET ? set_gaps : add_gaps, &amount);
 		top->gaps = top_gap;
-		arrange_windows(top, -1, -1);
+		schedule_arrange_windows(top);
 	}
 
 	return cmd_results_new(CMD_SUCCESS, NULL, NULL);
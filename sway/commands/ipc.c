@@ -88,6 +88,7 @@ struct cmd_results *cmd_ipc_cmd(int argc, char **argv) {
 		{ "tree", IPC_FEATURE_GET_TREE },
 		{ "marks", IPC_FEATURE_GET_MARKS },
 		{ "bar-config", IPC_FEATURE_GET_BAR_CONFIG },
+		{ "capture", IPC_FEATURE_CAPTURE },
 		{ "inputs", IPC_FEATURE_GET_INPUTS },
 		{ "clipboard", IPC_FEATURE_GET_CLIPBOARD },
 	};
@@ -139,6 +140,7 @@ struct cmd_results *cmd_ipc_event_cmd(int argc, char **argv) {
 		{ "window", IPC_FEATURE_EVENT_WINDOW },
 		{ "binding", IPC_FEATURE_EVENT_BINDING },
 		{ "input", IPC_FEATURE_EVENT_INPUT },
+		{ "tree", IPC_FEATURE_EVENT_TREE },
 	};
 
 	uint32_t type = 0;
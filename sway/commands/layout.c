@@ -69,7 +69,7 @@ struct cmd_results *cmd_layout(int argc, char **argv) {
 	update_layout_geometry(parent, old_layout);
 	update_geometry(parent);
 
-	arrange_windows(parent, parent->width, parent->height);
+	schedule_arrange_windows(parent);
 
 	return cmd_results_new(CMD_SUCCESS, NULL, NULL);
 }
@@ -190,7 +190,7 @@ static struct cmd_results *cmd_layout_auto(swayc_t *container, int argc, char **
 	}
 	if (need_layout_update) {
 		update_geometry(container);
-		arrange_windows(container, container->width, container->height);
+		schedule_arrange_windows(container);
 	}
 	return cmd_results_new(CMD_SUCCESS, NULL, NULL);
 }
@@ -2,18 +2,10 @@
 #include <strings.h>
 #include <stdbool.h>
 #include "sway/commands.h"
+#include "sway/mark_index.h"
 #include "list.h"
 #include "stringop.h"
 
-static void find_marks_callback(swayc_t *container, void *_mark) {
-	char *mark = (char *)_mark;
-
-	int index;
-	if (container->marks && ((index = list_seq_find(container->marks, (int (*)(const void *, const void *))strcmp, mark)) != -1)) {
-		list_del(container->marks, index);
-	}
-}
-
 struct cmd_results *cmd_mark(int argc, char **argv) {
 	struct cmd_results *error = NULL;
 	if (config->reading) return cmd_results_new(CMD_FAILURE, "mark", "Can't be used in config file.");
@@ -40,45 +32,20 @@ struct cmd_results *cmd_mark(int argc, char **argv) {
 	if (argc) {
 		char *mark = join_args(argv, argc);
 
-		// Remove all existing marks of this type
-		container_map(&root_container, find_marks_callback, mark);
-
-		if (view->marks) {
+		if (toggle && container_has_mark(view, mark)) {
 			if (add) {
-				int index;
-				if ((index = list_seq_find(view->marks, (int (*)(const void *, const void *))strcmp, mark)) != -1) {
-					if (toggle) {
-						free(view->marks->items[index]);
-						list_del(view->marks, index);
-
-						if (0 == view->marks->length) {
-							list_free(view->marks);
-							view->marks = NULL;
-						}
-					}
-					free(mark);
-				} else {
-					list_add(view->marks, mark);
-				}
+				container_remove_mark(view, mark);
 			} else {
-				if (toggle && list_seq_find(view->marks, (int (*)(const void *, const void *))strcmp, mark) != -1) {
-					// Delete the list
-					list_foreach(view->marks, free);
-					list_free(view->marks);
-					view->marks = NULL;
-				} else {
-					// Delete and replace with a new list
-					list_foreach(view->marks, free);
-					list_free(view->marks);
-
-					view->marks = create_list();
-					list_add(view->marks, mark);
-				}
+				container_clear_marks(view);
 			}
 		} else {
-			view->marks = create_list();
-			list_add(view->marks, mark);
+			if (!add) {
+				container_clear_marks(view);
+			}
+			// takes the mark from any other container
+			container_add_mark(view, mark);
 		}
+		free(mark);
 	} else {
 		return cmd_results_new(CMD_FAILURE, "mark",
 			"Expected 'mark [--add|--replace] [--toggle] <mark>'");
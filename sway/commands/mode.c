@@ -38,6 +38,7 @@ struct cmd_results *cmd_mode(int argc, char **argv) {
 		}
 		mode->name = strdup(mode_name);
 		mode->bindings = create_list();
+		mode->binding_index = NULL;
 		list_add(config->modes, mode);
 	}
 	if (!mode) {
@@ -146,6 +146,7 @@ struct cmd_results *cmd_move(int argc, char **argv) {
 		} else {
 			remove_child(view);
 		}
+		container_map(view, swayc_unindex_handle, NULL);
 		wlc_view_set_mask(view->handle, 0);
 		arrange_windows(swayc_active_workspace(), -1, -1);
 		swayc_t *focused = container_under_pointer();
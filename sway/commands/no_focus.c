@@ -36,6 +36,7 @@ struct cmd_results *cmd_no_focus(int argc, char **argv) {
 	} else {
 		sway_log(L_DEBUG, "no_focus: '%s' added", crit->crit_raw);
 		list_add(config->no_focus, crit);
+		criteria_index_invalidate(&config->no_focus_index);
 	}
 	return error ? error : cmd_results_new(CMD_SUCCESS, NULL, NULL);
 }
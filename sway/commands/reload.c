@@ -14,6 +14,6 @@ struct cmd_results *cmd_reload(int argc, char **argv) {
 
 	load_swaybars();
 
-	arrange_windows(&root_container, -1, -1);
+	schedule_arrange_windows(&root_container);
 	return cmd_results_new(CMD_SUCCESS, NULL, NULL);
 }
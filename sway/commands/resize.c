@@ -192,7 +192,7 @@ static bool resize_tiled(int amount, bool use_width) {
 		}
 		// Recursive resize does not handle positions, let arrange_windows
 		// take care of that.
-		arrange_windows(swayc_active_workspace(), -1, -1);
+		schedule_arrange_windows(swayc_active_workspace());
 	}
 	return true;
 }
@@ -27,9 +27,10 @@ static swayc_t *fetch_view_from_scratchpad() {
 	}
 
 	add_floating(swayc_active_workspace(), view);
+	container_map(view, swayc_index_handle, NULL);
 	wlc_view_set_mask(view->handle, VISIBLE);
 	view->visible = true;
-	arrange_windows(swayc_active_workspace(), -1, -1);
+	schedule_arrange_windows(swayc_active_workspace());
 	set_focused_container(view);
 	return view;
 }
@@ -38,7 +38,7 @@ static struct cmd_results *_do_split(int argc, char **argv, int layout) {
 		sway_log(L_INFO, "FOCUSED SIZE: %.f %.f", focused->width, focused->height);
 		swayc_t *parent = new_container(focused, layout);
 		set_focused_container(focused);
-		arrange_windows(parent, -1, -1);
+		schedule_arrange_windows(parent);
 	}
 
 	// update container every time
@@ -1,6 +1,7 @@
 #include <string.h>
 #include <strings.h>
 #include "sway/commands.h"
+#include "sway/mark_index.h"
 #include "list.h"
 #include "stringop.h"
 
@@ -10,21 +11,10 @@ struct cmd_results *cmd_unmark(int argc, char **argv) {
 	if (view->marks) {
 		if (argc) {
 			char *mark = join_args(argv, argc);
-			int index;
-			if ((index = list_seq_find(view->marks, (int (*)(const void *, const void *))strcmp, mark)) != -1) {
-				free(view->marks->items[index]);
-				list_del(view->marks, index);
-
-				if (view->marks->length == 0) {
-					list_free(view->marks);
-					view->marks = NULL;
-				}
-			}
+			container_remove_mark(view, mark);
 			free(mark);
 		} else {
-			list_foreach(view->marks, free);
-			list_free(view->marks);
-			view->marks = NULL;
+			container_clear_marks(view);
 		}
 	}
 	return cmd_results_new(CMD_SUCCESS, NULL, NULL);
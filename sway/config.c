@@ -23,6 +23,8 @@
 #include "sway/criteria.h"
 #include "sway/input.h"
 #include "sway/border.h"
+#include "sway/security.h"
+#include "sway/binding_index.h"
 #include "readline.h"
 #include "stringop.h"
 #include "list.h"
@@ -60,6 +62,7 @@ static void free_mode(struct sway_mode *mode) {
 		free_binding(mode->bindings->items[i]);
 	}
 	list_free(mode->bindings);
+	binding_index_free(mode->binding_index);
 	free(mode);
 }
 
@@ -259,6 +262,8 @@ void free_config(struct sway_config *config) {
 		free_criteria(config->no_focus->items[i]);
 	}
 	list_free(config->no_focus);
+	criteria_index_invalidate(&config->criteria_index);
+	criteria_index_invalidate(&config->no_focus_index);
 
 	for (i = 0; config->input_configs && i < config->input_configs->length; ++i) {
 		free_input_config(config->input_configs->items[i]);
@@ -312,6 +317,7 @@ static void config_defaults(struct sway_config *config) {
 	if (!(config->current_mode->name = malloc(sizeof("default")))) goto cleanup;
 	strcpy(config->current_mode->name, "default");
 	if (!(config->current_mode->bindings = create_list())) goto cleanup;
+	config->current_mode->binding_index = NULL;
 	list_add(config->modes, config->current_mode);
 
 	config->floating_mod = 0;
@@ -584,11 +590,18 @@ bool load_main_config(const char *file, bool is_active) {
 		free_config(old_config);
 	}
 	config->reading = false;
+	invalidate_feature_policy_cache();
 
 	if (success) {
 		update_active_bar_modifiers();
 	}
 
+	for (int i = 0; i < config->modes->length; ++i) {
+		binding_index_build(config->modes->items[i]);
+	}
+	criteria_index_build(&config->criteria_index, config->criteria);
+	criteria_index_build(&config->no_focus_index, config->no_focus);
+
 	return success;
 }
 
@@ -694,25 +707,28 @@ bool read_config(FILE *file, struct sway_config *config) {
 	bool success = true;
 	enum cmd_status block = CMD_BLOCK_END;
 
+	// The lines and their arguments live in these two buffers, reused for the
+	// whole file
+	struct line_reader lines;
+	if (!line_reader_init(&lines, file)) {
+		return false;
+	}
+	struct split_buffer args = { 0 };
+
 	int line_number = 0;
 	char *line;
-	while (!feof(file)) {
-		line = read_line(file);
-		if (!line) {
-			continue;
-		}
+	while ((line = line_reader_next(&lines))) {
 		line_number++;
-		line = strip_whitespace(line);
+		line = strip_whitespace_in_place(line);
 		if (line[0] == '#') {
-			free(line);
 			continue;
 		}
 		struct cmd_results *res;
 		if (block == CMD_BLOCK_COMMANDS) {
 			// Special case
-			res = config_commands_command(line);
+			res = config_commands_command(line, &args);
 		} else {
-			res = config_command(line, block);
+			res = config_command(line, block, &args);
 		}
 		switch(res->status) {
 		case CMD_FAILURE:
@@ -831,10 +847,11 @@ bool read_config(FILE *file, struct sway_config *config) {
 			}
 		default:;
 		}
-		free(line);
 		free_cmd_results(res);
 	}
 
+	split_buffer_finish(&args);
+	line_reader_finish(&lines);
 	return success;
 }
 
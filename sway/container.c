@@ -13,12 +13,27 @@
 #include "sway/input_state.h"
 #include "sway/ipc-server.h"
 #include "sway/output.h"
+#include "sway/hit_index.h"
+#include "sway/view_index.h"
+#include "sway/mark_index.h"
+#include "hashmap.h"
+#include "intern.h"
 #include "log.h"
 #include "stringop.h"
 
 #define ASSERT_NONNULL(PTR) \
 	sway_assert (PTR, #PTR "must be non-null")
 
+// wlc_handle -> swayc_t for every output and every view attached to the tree
+static hashmap_t *handle_index = NULL;
+
+static hashmap_t *get_handle_index(void) {
+	if (!handle_index) {
+		handle_index = create_hashmap(hash_ptr, compare_ptr);
+	}
+	return handle_index;
+}
+
 static swayc_t *new_swayc(enum swayc_types type) {
 	// next id starts at 1 because 0 is assigned to root_container in layout.c
 	static size_t next_id = 1;
@@ -61,32 +76,29 @@ static void free_swayc(swayc_t *cont) {
 		}
 		list_free(cont->floating);
 	}
-	if (cont->marks) {
-		list_foreach(cont->marks, free);
-		list_free(cont->marks);
-	}
+	container_clear_marks(cont);
 	if (cont->parent) {
 		remove_child(cont);
 	}
-	if (cont->name) {
-		free(cont->name);
-	}
-	if (cont->class) {
-		free(cont->class);
-	}
-	if (cont->instance) {
-		free(cont->instance);
+	swayc_unindex_handle(cont, NULL);
+	if (cont->type == C_VIEW) {
+		view_index_remove(cont);
 	}
-	if (cont->app_id) {
-		free(cont->app_id);
+	cancel_arrange_windows(cont);
+	hit_index_free(cont->hit_index);
+	if (cont->type == C_VIEW) {
+		intern_release(cont->name);
+	} else {
+		free(cont->name);
 	}
+	intern_release(cont->class);
+	intern_release(cont->instance);
+	intern_release(cont->app_id);
 	if (cont->bg_pid != 0) {
 		terminate_swaybg(cont->bg_pid);
 	}
 	if (cont->border) {
-		if (cont->border->buffer) {
-			free(cont->border->buffer);
-		}
+		border_clear(cont->border);
 		free(cont->border);
 	}
 	free(cont);
@@ -165,6 +177,7 @@ swayc_t *new_output(wlc_handle handle) {
 
 	swayc_t *output = new_swayc(C_OUTPUT);
 	output->handle = handle;
+	swayc_index_handle(output, NULL);
 	output->name = name ? strdup(name) : NULL;
 	output->width = size.w;
 	output->height = size.h;
@@ -299,13 +312,12 @@ swayc_t *new_view(swayc_t *sibling, wlc_handle handle) {
 		handle, title, sibling, sibling ? sibling->type : 0);
 	// Setup values
 	view->handle = handle;
-	view->name = title ? strdup(title) : NULL;
-	const char *class = wlc_view_get_class(handle);
-	view->class = class ? strdup(class) : NULL;
-	const char *instance = wlc_view_get_instance(handle);
-	view->instance = instance ? strdup(instance) : NULL;
-	const char *app_id = wlc_view_get_app_id(handle);
-	view->app_id = app_id ? strdup(app_id) : NULL;
+	swayc_index_handle(view, NULL);
+	view->name = (char *)intern_string(title);
+	view->class = intern_string(wlc_view_get_class(handle));
+	view->instance = intern_string(wlc_view_get_instance(handle));
+	view->app_id = intern_string(wlc_view_get_app_id(handle));
+	view_index_add(view);
 	view->visible = true;
 	view->is_focused = true;
 	view->sticky = false;
@@ -339,13 +351,12 @@ swayc_t *new_floating_view(wlc_handle handle) {
 		handle, wlc_view_get_type(handle), title);
 	// Setup values
 	view->handle = handle;
-	view->name = title ? strdup(title) : NULL;
-	const char *class = wlc_view_get_class(handle);
-	view->class = class ? strdup(class) : NULL;
-	const char *instance = wlc_view_get_instance(handle);
-	view->instance = instance ? strdup(instance) : NULL;
-	const char *app_id = wlc_view_get_app_id(handle);
-	view->app_id = app_id ? strdup(app_id) : NULL;
+	swayc_index_handle(view, NULL);
+	view->name = (char *)intern_string(title);
+	view->class = intern_string(wlc_view_get_class(handle));
+	view->instance = intern_string(wlc_view_get_instance(handle));
+	view->app_id = intern_string(wlc_view_get_app_id(handle));
+	view_index_add(view);
 	view->visible = true;
 	view->sticky = false;
 
@@ -621,39 +632,27 @@ swayc_t *swayc_focus_by_layout(swayc_t *container, enum swayc_layouts layout) {
 }
 
 
-static swayc_t *_swayc_by_handle_helper(wlc_handle handle, swayc_t *parent) {
-	if (!parent || !parent->children) {
-		return NULL;
-	}
-	int i, len;
-	swayc_t **child;
-	if (parent->type == C_WORKSPACE) {
-		len = parent->floating->length;
-		child = (swayc_t **)parent->floating->items;
-		for (i = 0; i < len; ++i, ++child) {
-			if ((*child)->handle == handle) {
-				return *child;
-			}
-		}
-	}
+swayc_t *swayc_by_handle(wlc_handle handle) {
+	return hashmap_get(get_handle_index(), (void *)handle);
+}
 
-	len = parent->children->length;
-	child = (swayc_t**)parent->children->items;
-	for (i = 0; i < len; ++i, ++child) {
-		if ((*child)->handle == handle) {
-			return *child;
-		} else {
-			swayc_t *res;
-			if ((res = _swayc_by_handle_helper(handle, *child))) {
-				return res;
-			}
-		}
+void swayc_index_handle(swayc_t *container, void *data) {
+	if (container->type != C_OUTPUT && container->type != C_VIEW) {
+		return;
+	}
+	if (!hashmap_set(get_handle_index(), (void *)container->handle, container)) {
+		sway_log(L_ERROR, "Unable to index handle of %p", container);
 	}
-	return NULL;
 }
 
-swayc_t *swayc_by_handle(wlc_handle handle) {
-	return _swayc_by_handle_helper(handle, &root_container);
+void swayc_unindex_handle(swayc_t *container, void *data) {
+	if (container->type != C_OUTPUT && container->type != C_VIEW) {
+		return;
+	}
+	// only drop the entry if it still refers to this container
+	if (hashmap_get(get_handle_index(), (void *)container->handle) == container) {
+		hashmap_del(handle_index, (void *)container->handle);
+	}
 }
 
 swayc_t *swayc_active_output(void) {
@@ -725,6 +724,12 @@ swayc_t *container_under_pointer(void) {
 				return NULL;
 			}
 		}
+		if (lookup->type == C_WORKSPACE) {
+			swayc_t *hit;
+			if (hit_index_container_at(lookup, origin.x, origin.y, &hit)) {
+				return hit;
+			}
+		}
 		// if tabbed/stacked go directly to focused container, otherwise search
 		// children
 		if (lookup->layout == L_TABBED || lookup->layout == L_STACKED) {
@@ -866,10 +871,107 @@ void container_map(swayc_t *container, void (*f)(swayc_t *view, void *data), voi
 	}
 }
 
+bool swayc_in_tree(swayc_t *container) {
+	while (container->parent) {
+		container = container->parent;
+	}
+	return container == &root_container;
+}
+
+// container -> its position among the children of its parent plus one, the
+// floating ones after the tiled ones, for tree_order_cmp
+static hashmap_t *tree_positions = NULL;
+
+static bool index_children(swayc_t *parent) {
+	int position = 0;
+	for (int i = 0; parent->children && i < parent->children->length; ++i) {
+		if (!hashmap_set(tree_positions, parent->children->items[i], (void *)(intptr_t)++position)) {
+			return false;
+		}
+	}
+	for (int i = 0; parent->floating && i < parent->floating->length; ++i) {
+		if (!hashmap_set(tree_positions, parent->floating->items[i], (void *)(intptr_t)++position)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Records the position of every ancestor of the containers in list. Each parent on
+ * the way has its children numbered once, so this costs no more than the
+ * containers' depth plus the children of the containers they are in. Returns false
+ * if the table couldn't grow.
+ */
+static bool index_tree_positions(list_t *list) {
+	for (int i = 0; i < list->length; ++i) {
+		for (swayc_t *c = list->items[i]; c->parent; c = c->parent) {
+			if (hashmap_get(tree_positions, c)) {
+				// its ancestors were numbered along with it
+				break;
+			}
+			if (!index_children(c->parent)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Sorts containers the way container_map visits them, after index_tree_positions.
+static int tree_order_cmp(const void *_a, const void *_b) {
+	swayc_t *a = *(swayc_t **)_a, *b = *(swayc_t **)_b;
+	int depth_a = 0, depth_b = 0;
+	for (swayc_t *c = a; c->parent; c = c->parent) {
+		++depth_a;
+	}
+	for (swayc_t *c = b; c->parent; c = c->parent) {
+		++depth_b;
+	}
+	int deeper = depth_a > depth_b ? -1 : depth_a < depth_b;
+	for (; depth_a > depth_b; --depth_a) {
+		a = a->parent;
+	}
+	for (; depth_b > depth_a; --depth_b) {
+		b = b->parent;
+	}
+	if (a == b) {
+		// one contains the other, container_map visits children first
+		return deeper;
+	}
+	while (a->parent != b->parent) {
+		a = a->parent;
+		b = b->parent;
+	}
+	intptr_t position_a = (intptr_t)hashmap_get(tree_positions, a);
+	intptr_t position_b = (intptr_t)hashmap_get(tree_positions, b);
+	return position_a < position_b ? -1 : position_a > position_b;
+}
+
+void container_sort_tree_order(list_t *list) {
+	if (list->length < 2) {
+		return;
+	}
+	if (!tree_positions && !(tree_positions = create_hashmap(hash_ptr, compare_ptr))) {
+		sway_log(L_ERROR, "Unable to allocate tree positions");
+		return;
+	}
+	if (index_tree_positions(list)) {
+		list_qsort(list, tree_order_cmp);
+	} else {
+		sway_log(L_ERROR, "Unable to allocate tree positions");
+	}
+	// the table is kept around, its contents go stale with the tree
+	hashmap_clear(tree_positions);
+}
+
 void update_visibility_output(swayc_t *container, wlc_handle output) {
 	// Inherit visibility
 	swayc_t *parent = container->parent;
 	container->visible = parent->visible;
+	if (container->type == C_WORKSPACE) {
+		hit_index_invalidate(container);
+	}
 	// special cases where visibility depends on focus
 	if (parent->type == C_OUTPUT || parent->layout == L_TABBED ||
 			parent->layout == L_STACKED) {
@@ -897,8 +999,20 @@ void update_visibility_output(swayc_t *container, wlc_handle output) {
 	}
 }
 
+static uint64_t tree_generation = 0;
+
+uint64_t get_tree_generation(void) {
+	return tree_generation;
+}
+
+void bump_tree_generation(void) {
+	tree_generation++;
+	ipc_event_tree_changed();
+}
+
 void update_visibility(swayc_t *container) {
 	if (!container) return;
+	bump_tree_generation();
 	switch (container->type) {
 	case C_ROOT:
 		container->visible = true;
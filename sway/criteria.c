@@ -2,11 +2,17 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 #include <pcre.h>
 #include "sway/criteria.h"
 #include "sway/container.h"
 #include "sway/config.h"
+#include "sway/view_index.h"
+#include "sway/mark_index.h"
 #include "stringop.h"
+#include "hashmap.h"
+#include "intern.h"
 #include "list.h"
 #include "log.h"
 
@@ -41,6 +47,15 @@ static const char * const criteria_strings[CRIT_LAST] = {
 	[CRIT_WORKSPACE] = "workspace"
 };
 
+// Regexes that are plain strings are matched without pcre
+enum crit_literal {
+	LITERAL_NONE,
+	LITERAL_SUBSTRING, // "abc"
+	LITERAL_PREFIX, // "^abc"
+	LITERAL_SUFFIX, // "abc$"
+	LITERAL_EXACT, // "^abc$"
+};
+
 /**
  * A single criteria token (ie. value/regex pair),
  * e.g. 'class="some class regex"'.
@@ -48,16 +63,39 @@ static const char * const criteria_strings[CRIT_LAST] = {
 struct crit_token {
 	enum criteria_type type;
 	pcre *regex;
+	pcre_extra *extra;
 	char *raw;
+	// "focused" or "__focused__"
+	bool focused;
+	enum crit_literal literal;
+	char *literal_value;
+	size_t literal_length;
+	// exact literals of view attributes are interned and compared by pointer
+	bool literal_interned;
+	// parsed con_id, con_id_valid is false if raw isn't a number
+	size_t con_id;
+	bool con_id_valid;
 };
 
 static void free_crit_token(struct crit_token *crit) {
+	if (crit->extra) {
+#ifdef PCRE_STUDY_JIT_COMPILE
+		pcre_free_study(crit->extra);
+#else
+		pcre_free(crit->extra);
+#endif
+	}
 	pcre_free(crit->regex);
+	if (crit->literal_interned) {
+		intern_release(crit->literal_value);
+	} else {
+		free(crit->literal_value);
+	}
 	free(crit->raw);
 	free(crit);
 }
 
-static void free_crit_tokens(list_t *crit_tokens) {
+void free_crit_tokens(list_t *crit_tokens) {
 	for (int i = 0; i < crit_tokens->length; i++) {
 		free_crit_token(crit_tokens->items[i]);
 	}
@@ -230,6 +268,103 @@ static bool crit_is_focused(const char *value) {
 	return !strcmp(value, "focused") || !strcmp(value, "__focused__");
 }
 
+// Studies the regex, with the JIT where pcre has one. Failing is not fatal,
+// pcre_exec works without it.
+static void study_regex(struct crit_token *token) {
+	const char *error = NULL;
+#ifdef PCRE_STUDY_JIT_COMPILE
+	token->extra = pcre_study(token->regex, PCRE_STUDY_JIT_COMPILE, &error);
+#else
+	token->extra = pcre_study(token->regex, 0, &error);
+#endif
+	if (error) {
+		sway_log(L_DEBUG, "Unable to study regex '%s': %s", token->raw, error);
+	}
+}
+
+/**
+ * Sets token->literal if the regex in value only matches a fixed string, with
+ * or without anchors. Backslash escaped punctuation counts as literal.
+ */
+static void parse_literal(struct crit_token *token, const char *value) {
+	size_t length = strlen(value);
+	bool prefix = false, suffix = false;
+	if (length > 0 && value[0] == '^') {
+		prefix = true;
+		++value;
+		--length;
+	}
+	if (length > 0 && value[length - 1] == '$'
+			&& (length < 2 || value[length - 2] != '\\')) {
+		suffix = true;
+		--length;
+	}
+	char *literal = malloc(length + 1);
+	if (!literal) {
+		return;
+	}
+	size_t j = 0;
+	for (size_t i = 0; i < length; ++i) {
+		char c = value[i];
+		if (c == '\\') {
+			c = value[++i];
+			if (i == length || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')
+					|| (c >= 'A' && c <= 'Z') || (unsigned char)c >= 0x80) {
+				// \d, \b, back references and friends
+				free(literal);
+				return;
+			}
+		} else if (strchr("^$.[|()?*+{", c)) {
+			free(literal);
+			return;
+		}
+		literal[j++] = c;
+	}
+	literal[j] = '\0';
+	token->literal = prefix && suffix ? LITERAL_EXACT : prefix ? LITERAL_PREFIX
+		: suffix ? LITERAL_SUFFIX : LITERAL_SUBSTRING;
+	token->literal_value = literal;
+	token->literal_length = j;
+}
+
+// Compiles the value of token into the form criteria_test needs. Returns
+// error string on failure or NULL otherwise.
+static char *compile_crit_token(struct crit_token *token) {
+	token->focused = crit_is_focused(token->raw);
+	switch (token->type) {
+	case CRIT_CON_ID: {
+		char *endptr;
+		token->con_id = strtoul(token->raw, &endptr, 10);
+		token->con_id_valid = *token->raw && *endptr == 0;
+		break;
+	}
+	case CRIT_URGENT:
+	case CRIT_WINDOW_ROLE:
+	case CRIT_WINDOW_TYPE:
+		return NULL;
+	default:
+		break;
+	}
+	if (token->focused) {
+		return NULL;
+	}
+	char *error = generate_regex(&token->regex, token->raw);
+	if (error) {
+		return error;
+	}
+	study_regex(token);
+	parse_literal(token, token->raw);
+	if (token->literal == LITERAL_EXACT && token->type != CRIT_WORKSPACE) {
+		char *interned = (char *)intern_string(token->literal_value);
+		if (interned) {
+			free(token->literal_value);
+			token->literal_value = interned;
+			token->literal_interned = true;
+		}
+	}
+	return NULL;
+}
+
 // Populate list with crit_tokens extracted from criteria string, returns error
 // string or NULL if successful.
 char *extract_crit_tokens(list_t *tokens, const char * const criteria) {
@@ -246,14 +381,15 @@ char *extract_crit_tokens(list_t *tokens, const char * const criteria) {
 		if ((error = parse_criteria_name(&token->type, name))) {
 			free_crit_token(token);
 			goto ect_cleanup;
-		} else if (token->type == CRIT_URGENT || crit_is_focused(value)) {
-			sway_log(L_DEBUG, "%s -> \"%s\"", name, value);
-			list_add(tokens, token);
-		} else if((error = generate_regex(&token->regex, value))) {
+		} else if ((error = compile_crit_token(token))) {
 			free_crit_token(token);
 			goto ect_cleanup;
+		} else if (token->regex) {
+			sway_log(L_DEBUG, "%s -> /%s/%s", name, value,
+					token->literal != LITERAL_NONE ? " (literal)" : "");
+			list_add(tokens, token);
 		} else {
-			sway_log(L_DEBUG, "%s -> /%s/", name, value);
+			sway_log(L_DEBUG, "%s -> \"%s\"", name, value);
 			list_add(tokens, token);
 		}
 	}
@@ -263,107 +399,159 @@ ect_cleanup:
 	return error;
 }
 
-static int regex_cmp(const char *item, const pcre *regex) {
-	return pcre_exec(regex, NULL, item, strlen(item), 0, 0, NULL, 0);
+// Whether value is literal followed by one newline, which a $ anchor accepts
+// as well as the end of the value.
+static bool equals_before_newline(const char *value, const char *literal, size_t length) {
+	return strncmp(value, literal, length) == 0
+		&& value[length] == '\n' && value[length + 1] == '\0';
+}
+
+// Returns true if value matches the regex (or literal) of token. value has to
+// be interned if the literal is.
+static bool token_matches(const struct crit_token *token, const char *value) {
+	if (token->literal == LITERAL_NONE) {
+		return token->regex && pcre_exec(token->regex, token->extra,
+				value, strlen(value), 0, 0, NULL, 0) == 0;
+	}
+	const char *literal = token->literal_value;
+	size_t length = token->literal_length;
+	switch (token->literal) {
+	case LITERAL_SUBSTRING:
+		return strstr(value, literal) != NULL;
+	case LITERAL_PREFIX:
+		return strncmp(value, literal, length) == 0;
+	case LITERAL_SUFFIX: {
+		size_t value_length = strlen(value);
+		if (value_length > 0 && value[value_length - 1] == '\n'
+				&& value_length > length
+				&& memcmp(value + value_length - 1 - length, literal, length) == 0) {
+			return true;
+		}
+		return value_length >= length
+			&& memcmp(value + value_length - length, literal, length) == 0;
+	}
+	case LITERAL_EXACT:
+		if (token->literal_interned ? value == literal : strcmp(value, literal) == 0) {
+			return true;
+		}
+		return equals_before_newline(value, literal, length);
+	default:
+		return false;
+	}
+}
+
+static int token_cmp(const void *item, const void *token) {
+	return token_matches(token, item) ? 0 : 1;
+}
+
+/**
+ * Focused containers looked up at most once per query, instead of once per
+ * token.
+ */
+struct criteria_focus {
+	bool resolved;
+	swayc_t *view;
+	swayc_t *workspace;
+};
+
+static void resolve_focus(struct criteria_focus *focus) {
+	if (!focus->resolved) {
+		focus->view = get_focused_view(&root_container);
+		focus->workspace = swayc_active_workspace();
+		focus->resolved = true;
+	}
 }
 
 // test a single view if it matches list of criteria tokens (all of them).
-static bool criteria_test(swayc_t *cont, list_t *tokens) {
+static bool criteria_test(swayc_t *cont, list_t *tokens, struct criteria_focus *focus) {
 	if (cont->type != C_VIEW) {
 		return false;
 	}
-	int matches = 0;
 	for (int i = 0; i < tokens->length; i++) {
 		struct crit_token *crit = tokens->items[i];
 		switch (crit->type) {
 		case CRIT_CLASS:
 			if (!cont->class) {
-				// ignore
-			} else if (crit_is_focused(crit->raw)) {
-				swayc_t *focused = get_focused_view(&root_container);
-				if (focused->class && strcmp(cont->class, focused->class) == 0) {
-					matches++;
+				return false;
+			} else if (crit->focused) {
+				resolve_focus(focus);
+				if (!focus->view->class || strcmp(cont->class, focus->view->class) != 0) {
+					return false;
 				}
-			} else if (crit->regex && regex_cmp(cont->class, crit->regex) == 0) {
-				matches++;
+			} else if (!token_matches(crit, cont->class)) {
+				return false;
 			}
 			break;
-		case CRIT_CON_ID: {
-			char *endptr;
-			size_t crit_id = strtoul(crit->raw, &endptr, 10);
-
-			if (*endptr == 0 && cont->id == crit_id) {
-				++matches;
+		case CRIT_CON_ID:
+			if (!crit->con_id_valid || cont->id != crit->con_id) {
+				return false;
 			}
 			break;
-		}
 		case CRIT_CON_MARK:
-			if (crit->regex && cont->marks && (list_seq_find(cont->marks, (int (*)(const void *, const void *))regex_cmp, crit->regex) != -1)) {
-				// Make sure it isn't matching the NUL string
-				if ((strcmp(crit->raw, "") == 0) == (list_seq_find(cont->marks, (int (*)(const void *, const void *))strcmp, "") != -1)) {
-					++matches;
-				}
+			if (!crit->regex || !cont->marks
+					|| list_seq_find(cont->marks, token_cmp, crit) == -1) {
+				return false;
+			}
+			// Make sure it isn't matching the NUL string
+			if ((strcmp(crit->raw, "") == 0) != (list_seq_find(cont->marks, (int (*)(const void *, const void *))strcmp, "") != -1)) {
+				return false;
 			}
 			break;
 		case CRIT_FLOATING:
-			if (cont->is_floating) {
-				matches++;
+			if (!cont->is_floating) {
+				return false;
 			}
 			break;
 		case CRIT_ID:
-			if (!cont->app_id) {
-				// ignore
-			} else if (crit->regex && regex_cmp(cont->app_id, crit->regex) == 0) {
-				matches++;
+			if (!cont->app_id || !token_matches(crit, cont->app_id)) {
+				return false;
 			}
 			break;
 		case CRIT_INSTANCE:
 			if (!cont->instance) {
-				// ignore
-			} else if (crit_is_focused(crit->raw)) {
-				swayc_t *focused = get_focused_view(&root_container);
-				if (focused->instance && strcmp(cont->instance, focused->instance) == 0) {
-					matches++;
+				return false;
+			} else if (crit->focused) {
+				resolve_focus(focus);
+				if (!focus->view->instance || strcmp(cont->instance, focus->view->instance) != 0) {
+					return false;
 				}
-			} else if (crit->regex && regex_cmp(cont->instance, crit->regex) == 0) {
-				matches++;
+			} else if (!token_matches(crit, cont->instance)) {
+				return false;
 			}
 			break;
 		case CRIT_TILING:
-			if (!cont->is_floating) {
-				matches++;
+			if (cont->is_floating) {
+				return false;
 			}
 			break;
 		case CRIT_TITLE:
 			if (!cont->name) {
-				// ignore
-			} else if (crit_is_focused(crit->raw)) {
-				swayc_t *focused = get_focused_view(&root_container);
-				if (focused->name && strcmp(cont->name, focused->name) == 0) {
-					matches++;
+				return false;
+			} else if (crit->focused) {
+				resolve_focus(focus);
+				if (!focus->view->name || strcmp(cont->name, focus->view->name) != 0) {
+					return false;
 				}
-			} else if (crit->regex && regex_cmp(cont->name, crit->regex) == 0) {
-				matches++;
+			} else if (!token_matches(crit, cont->name)) {
+				return false;
 			}
 			break;
 		case CRIT_URGENT: // "latest" or "oldest"
-			break;
 		case CRIT_WINDOW_ROLE:
-			break;
 		case CRIT_WINDOW_TYPE:
 			// TODO wlc indeed exposes this information
-			break;
+			return false;
 		case CRIT_WORKSPACE: ;
 			swayc_t *cont_ws = swayc_parent_by_type(cont, C_WORKSPACE);
 			if (!cont_ws || !cont_ws->name) {
-				// ignore
-			} else if (crit_is_focused(crit->raw)) {
-				swayc_t *focused_ws = swayc_active_workspace();
-				if (focused_ws->name && strcmp(cont_ws->name, focused_ws->name) == 0) {
-					matches++;
+				return false;
+			} else if (crit->focused) {
+				resolve_focus(focus);
+				if (!focus->workspace->name || strcmp(cont_ws->name, focus->workspace->name) != 0) {
+					return false;
 				}
-			} else if (crit->regex && regex_cmp(cont_ws->name, crit->regex) == 0) {
-				matches++;
+			} else if (!token_matches(crit, cont_ws->name)) {
+				return false;
 			}
 			break;
 		default:
@@ -371,7 +559,7 @@ static bool criteria_test(swayc_t *cont, list_t *tokens) {
 			break;
 		}
 	}
-	return matches == tokens->length;
+	return true;
 }
 
 int criteria_cmp(const void *a, const void *b) {
@@ -403,46 +591,496 @@ void free_criteria(struct criteria *crit) {
 	free(crit);
 }
 
-bool criteria_any(swayc_t *cont, list_t *criteria) {
-	for (int i = 0; i < criteria->length; i++) {
-		struct criteria *bc = criteria->items[i];
-		if (criteria_test(cont, bc->tokens)) {
-			return true;
+struct criteria_key {
+	enum criteria_type type;
+	bool prefix;
+	const char *value;
+};
+
+// positions of criteria in the indexed list, ascending
+struct criteria_bucket {
+	struct criteria_key key;
+	size_t value_length;
+	int *positions;
+	int length, capacity;
+};
+
+/**
+ * Prefix buckets of one attribute, sorted by prefix length and then value, so
+ * the prefixes a value starts with are found by one binary search per length.
+ */
+struct criteria_prefixes {
+	struct criteria_bucket **buckets;
+	int length;
+	size_t *lengths; // distinct prefix lengths, ascending
+	int length_count;
+};
+
+// the attributes with exact and prefix buckets
+static const enum criteria_type indexed_types[] = { CRIT_CLASS, CRIT_INSTANCE, CRIT_ID };
+#define INDEXED_TYPES (sizeof(indexed_types) / sizeof(indexed_types[0]))
+
+/**
+ * Criteria of a list by the exact value or the prefix of the class, instance
+ * or app_id they require, so a view is only tested against criteria that can
+ * match its attributes. Criteria without such a token (e.g. an unanchored
+ * class="Firefox", which matches anywhere in the class) are tested against
+ * every view and the ones that can never match are left out.
+ */
+struct criteria_index {
+	hashmap_t *buckets; // struct criteria_key -> struct criteria_bucket
+	struct criteria_prefixes prefixes[INDEXED_TYPES];
+	struct criteria_bucket rest;
+	// room for every bucket one view can hit, used by criteria_match
+	struct criteria_bucket **found;
+	int *next;
+};
+
+static uint32_t hash_criteria_key(const void *_key) {
+	const struct criteria_key *key = _key;
+	return hash_string(key->value) ^ ((uint32_t)(key->type * 2 + key->prefix) * 0x9E3779B9u);
+}
+
+static int compare_criteria_key(const void *_a, const void *_b) {
+	const struct criteria_key *a = _a, *b = _b;
+	return a->type != b->type || a->prefix != b->prefix || strcmp(a->value, b->value) != 0;
+}
+
+static void free_bucket(const void *key, void *value, void *data) {
+	struct criteria_bucket *bucket = value;
+	free(bucket->positions);
+	free(bucket);
+}
+
+static void criteria_index_free(struct criteria_index *index) {
+	if (!index) {
+		return;
+	}
+	if (index->buckets) {
+		hashmap_foreach(index->buckets, free_bucket, NULL);
+		hashmap_free(index->buckets);
+	}
+	for (size_t t = 0; t < INDEXED_TYPES; ++t) {
+		free(index->prefixes[t].buckets);
+		free(index->prefixes[t].lengths);
+	}
+	free(index->rest.positions);
+	free(index->found);
+	free(index->next);
+	free(index);
+}
+
+void criteria_index_invalidate(struct criteria_index **index) {
+	criteria_index_free(*index);
+	*index = NULL;
+}
+
+static bool bucket_add(struct criteria_bucket *bucket, int position) {
+	if (bucket->length == bucket->capacity) {
+		int capacity = bucket->capacity ? bucket->capacity * 2 : 4;
+		int *positions = realloc(bucket->positions, capacity * sizeof(int));
+		if (!positions) {
+			return false;
+		}
+		bucket->positions = positions;
+		bucket->capacity = capacity;
+	}
+	bucket->positions[bucket->length++] = position;
+	return true;
+}
+
+static int indexed_type_slot(enum criteria_type type) {
+	for (size_t t = 0; t < INDEXED_TYPES; ++t) {
+		if (indexed_types[t] == type) {
+			return (int)t;
+		}
+	}
+	return -1;
+}
+
+// Returns the token criteria are indexed by, NULL if there is none. never is
+// set if no view can match the tokens.
+static struct crit_token *index_token(list_t *tokens, bool *never) {
+	struct crit_token *best = NULL;
+	// exact values before prefixes, then in the order of indexed_types
+	size_t best_rank = INDEXED_TYPES * 2;
+	*never = false;
+	for (int i = 0; i < tokens->length; ++i) {
+		struct crit_token *token = tokens->items[i];
+		switch (token->type) {
+		case CRIT_URGENT:
+		case CRIT_WINDOW_ROLE:
+		case CRIT_WINDOW_TYPE:
+			*never = true;
+			return NULL;
+		case CRIT_CON_ID:
+			if (!token->con_id_valid) {
+				*never = true;
+				return NULL;
+			}
+			break;
+		default:
+			break;
+		}
+		int slot = indexed_type_slot(token->type);
+		if (slot == -1 || (token->literal != LITERAL_EXACT && token->literal != LITERAL_PREFIX)) {
+			continue;
+		}
+		size_t rank = slot + (token->literal == LITERAL_PREFIX ? INDEXED_TYPES : 0);
+		if (rank < best_rank) {
+			best = token;
+			best_rank = rank;
+		}
+	}
+	return best;
+}
+
+// Orders prefix buckets by length, then value.
+static int prefix_bucket_cmp(const void *_a, const void *_b) {
+	const struct criteria_bucket *a = *(void **)_a, *b = *(void **)_b;
+	if (a->value_length != b->value_length) {
+		return a->value_length < b->value_length ? -1 : 1;
+	}
+	return strcmp(a->key.value, b->key.value);
+}
+
+struct prefix_collect {
+	struct criteria_index *index;
+	bool failed;
+};
+
+static void collect_prefix_bucket(const void *key, void *value, void *data) {
+	struct criteria_bucket *bucket = value;
+	struct prefix_collect *collect = data;
+	if (!bucket->key.prefix) {
+		return;
+	}
+	struct criteria_prefixes *prefixes =
+		&collect->index->prefixes[indexed_type_slot(bucket->key.type)];
+	struct criteria_bucket **buckets = realloc(prefixes->buckets,
+			(prefixes->length + 1) * sizeof(struct criteria_bucket *));
+	if (!buckets) {
+		collect->failed = true;
+		return;
+	}
+	prefixes->buckets = buckets;
+	prefixes->buckets[prefixes->length++] = bucket;
+}
+
+// Sorts the prefix buckets and sets up the lookup and merge scratch space.
+static bool criteria_index_finish(struct criteria_index *index) {
+	struct prefix_collect collect = { index, false };
+	hashmap_foreach(index->buckets, collect_prefix_bucket, &collect);
+	if (collect.failed) {
+		return false;
+	}
+	// rest, two exact buckets per attribute (see find_buckets) and one prefix
+	// bucket per length
+	int found = 1 + INDEXED_TYPES * 2;
+	for (size_t t = 0; t < INDEXED_TYPES; ++t) {
+		struct criteria_prefixes *prefixes = &index->prefixes[t];
+		if (!prefixes->length) {
+			continue;
+		}
+		qsort(prefixes->buckets, prefixes->length, sizeof(struct criteria_bucket *),
+				prefix_bucket_cmp);
+		if (!(prefixes->lengths = malloc(prefixes->length * sizeof(size_t)))) {
+			return false;
+		}
+		for (int i = 0; i < prefixes->length; ++i) {
+			size_t length = prefixes->buckets[i]->value_length;
+			if (!prefixes->length_count
+					|| prefixes->lengths[prefixes->length_count - 1] != length) {
+				prefixes->lengths[prefixes->length_count++] = length;
+			}
 		}
+		found += prefixes->length_count;
 	}
+	index->found = malloc(found * sizeof(struct criteria_bucket *));
+	index->next = malloc(found * sizeof(int));
+	return index->found && index->next;
+}
+
+bool criteria_index_build(struct criteria_index **_index, list_t *criteria) {
+	criteria_index_invalidate(_index);
+	struct criteria_index *index = calloc(1, sizeof(struct criteria_index));
+	if (!index || !(index->buckets = create_hashmap(hash_criteria_key, compare_criteria_key))) {
+		sway_log(L_ERROR, "Unable to allocate criteria index");
+		free(index);
+		return false;
+	}
+	int never_count = 0, prefix_count = 0;
+	for (int i = 0; i < criteria->length; ++i) {
+		struct criteria *crit = criteria->items[i];
+		bool never;
+		struct crit_token *token = index_token(crit->tokens, &never);
+		if (never) {
+			++never_count;
+			continue;
+		}
+		struct criteria_bucket *bucket = &index->rest;
+		if (token) {
+			struct criteria_key key = {
+				token->type, token->literal == LITERAL_PREFIX, token->literal_value
+			};
+			if (!(bucket = hashmap_get(index->buckets, &key))) {
+				if (!(bucket = calloc(1, sizeof(struct criteria_bucket)))) {
+					goto error;
+				}
+				bucket->key = key;
+				bucket->value_length = token->literal_length;
+				if (!hashmap_set(index->buckets, &bucket->key, bucket)) {
+					free(bucket);
+					goto error;
+				}
+				prefix_count += key.prefix;
+			}
+		}
+		if (!bucket_add(bucket, i)) {
+			goto error;
+		}
+	}
+	if (!criteria_index_finish(index)) {
+		goto error;
+	}
+	sway_log(L_DEBUG, "Compiled %d criteria into %d exact and %d prefix buckets, "
+			"%d scanned, %d never match", criteria->length,
+			index->buckets->length - prefix_count, prefix_count,
+			index->rest.length, never_count);
+	*_index = index;
+	return true;
+error:
+	sway_log(L_ERROR, "Unable to build criteria index");
+	criteria_index_free(index);
 	return false;
 }
 
-list_t *criteria_for(swayc_t *cont) {
-	list_t *criteria = config->criteria, *matches = create_list();
-	for (int i = 0; i < criteria->length; i++) {
-		struct criteria *bc = criteria->items[i];
-		if (criteria_test(cont, bc->tokens)) {
-			list_add(matches, bc);
+/**
+ * Adds the buckets of the criteria that can match value in attribute slot t
+ * to found: its exact bucket and the bucket of every prefix it starts with.
+ * Returns the number added.
+ */
+static int find_buckets(struct criteria_index *index, size_t t, const char *value,
+		struct criteria_bucket **found) {
+	if (!value) {
+		return 0;
+	}
+	int count = 0;
+	struct criteria_key key = { indexed_types[t], false, value };
+	if ((found[count] = hashmap_get(index->buckets, &key))) {
+		++count;
+	}
+	size_t value_length = strlen(value);
+	if (value_length > 0 && value[value_length - 1] == '\n') {
+		// "^abc$" matches "abc\n" as well
+		char *stripped = strndup(value, value_length - 1);
+		if (stripped) {
+			key.value = stripped;
+			if ((found[count] = hashmap_get(index->buckets, &key))) {
+				++count;
+			}
+			free(stripped);
 		}
 	}
+	struct criteria_prefixes *prefixes = &index->prefixes[t];
+	for (int l = 0; l < prefixes->length_count && prefixes->lengths[l] <= value_length; ++l) {
+		size_t length = prefixes->lengths[l];
+		// first bucket not before value[0..length) in prefix_bucket_cmp order
+		int low = 0, high = prefixes->length;
+		while (low < high) {
+			int mid = low + (high - low) / 2;
+			struct criteria_bucket *bucket = prefixes->buckets[mid];
+			if (bucket->value_length < length || (bucket->value_length == length
+						&& strncmp(bucket->key.value, value, length) < 0)) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		if (low < prefixes->length && prefixes->buckets[low]->value_length == length
+				&& strncmp(prefixes->buckets[low]->key.value, value, length) == 0) {
+			found[count++] = prefixes->buckets[low];
+		}
+	}
+	return count;
+}
+
+/**
+ * Tests cont against the criteria that may match it, in list order. Matches
+ * are added to matches if given, otherwise the first match ends the search.
+ * Returns whether any criteria matched.
+ */
+static bool criteria_match(swayc_t *cont, list_t *criteria,
+		struct criteria_index **index, list_t *matches) {
+	if (cont->type != C_VIEW) {
+		return false;
+	}
+	struct criteria_focus focus = { 0 };
+	if (!*index && !criteria_index_build(index, criteria)) {
+		// test everything
+		bool matched = false;
+		for (int i = 0; i < criteria->length; i++) {
+			struct criteria *crit = criteria->items[i];
+			if (criteria_test(cont, crit->tokens, &focus)) {
+				matched = true;
+				if (!matches) {
+					break;
+				}
+				list_add(matches, crit);
+			}
+		}
+		return matched;
+	}
+
+	struct criteria_bucket **buckets = (*index)->found;
+	int *next = (*index)->next;
+	const char *values[INDEXED_TYPES] = { cont->class, cont->instance, cont->app_id };
+	int bucket_count = 0;
+	buckets[bucket_count++] = &(*index)->rest;
+	for (size_t t = 0; t < INDEXED_TYPES; ++t) {
+		bucket_count += find_buckets(*index, t, values[t], buckets + bucket_count);
+	}
+	memset(next, 0, bucket_count * sizeof(int));
+	bool matched = false;
+	while (true) {
+		// every criteria is in one bucket, merge them by position
+		int best = -1;
+		for (int b = 0; b < bucket_count; ++b) {
+			if (next[b] < buckets[b]->length && (best == -1
+					|| buckets[b]->positions[next[b]] < buckets[best]->positions[next[best]])) {
+				best = b;
+			}
+		}
+		if (best == -1) {
+			break;
+		}
+		struct criteria *crit = criteria->items[buckets[best]->positions[next[best]++]];
+		if (criteria_test(cont, crit->tokens, &focus)) {
+			matched = true;
+			if (!matches) {
+				break;
+			}
+			list_add(matches, crit);
+		}
+	}
+	return matched;
+}
+
+bool criteria_any(swayc_t *cont, list_t *criteria, struct criteria_index **index) {
+	return criteria_match(cont, criteria, index, NULL);
+}
+
+list_t *criteria_for(swayc_t *cont) {
+	list_t *matches = create_list();
+	criteria_match(cont, config->criteria, &config->criteria_index, matches);
 	return matches;
 }
 
 struct list_tokens {
 	list_t *list;
 	list_t *tokens;
+	struct criteria_focus focus;
 };
 
 static void container_match_add(swayc_t *container, struct list_tokens *list_tokens) {
-	if (criteria_test(container, list_tokens->tokens)) {
+	if (criteria_test(container, list_tokens->tokens, &list_tokens->focus)) {
 		list_add(list_tokens->list, container);
 	}
 }
 
+// Returns the literal of token followed by a newline, which an exact literal
+// also matches, or NULL if out of memory.
+static char *with_newline(const struct crit_token *token) {
+	char *value = malloc(token->literal_length + 2);
+	if (value) {
+		memcpy(value, token->literal_value, token->literal_length);
+		value[token->literal_length] = '\n';
+		value[token->literal_length + 1] = '\0';
+	}
+	return value;
+}
+
+/**
+ * Adds the views that can match tokens to candidates, looked up by con_id, an
+ * exact con_mark or by an exact or prefix class, instance or app_id. Returns
+ * false if tokens have no such term.
+ */
+static bool indexed_candidates(list_t *tokens, list_t *candidates) {
+	struct crit_token *best = NULL;
+	int best_rank = 0;
+	for (int i = 0; i < tokens->length; ++i) {
+		struct crit_token *token = tokens->items[i];
+		if (token->type == CRIT_CON_ID) {
+			swayc_t *view = token->con_id_valid ? view_index_by_id(token->con_id) : NULL;
+			if (view) {
+				list_add(candidates, view);
+			}
+			return true;
+		}
+		if (token->type == CRIT_CON_MARK && token->literal == LITERAL_EXACT) {
+			char *newline = with_newline(token);
+			swayc_t *containers[] = {
+				mark_index_find(token->literal_value),
+				newline ? mark_index_find(newline) : NULL,
+			};
+			free(newline);
+			for (size_t j = 0; j < sizeof(containers) / sizeof(containers[0]); ++j) {
+				// both marks may be on the same view
+				if (containers[j] && containers[j]->type == C_VIEW
+						&& (j == 0 || containers[j] != containers[0])) {
+					list_add(candidates, containers[j]);
+				}
+			}
+			return true;
+		}
+		if ((token->type != CRIT_CLASS && token->type != CRIT_INSTANCE && token->type != CRIT_ID)
+				|| (token->literal != LITERAL_EXACT && token->literal != LITERAL_PREFIX)) {
+			continue;
+		}
+		// exact terms select fewer views than prefixes
+		int rank = token->literal == LITERAL_EXACT ? 2 : 1;
+		if (rank > best_rank) {
+			best = token;
+			best_rank = rank;
+		}
+	}
+	if (!best) {
+		return false;
+	}
+	enum view_attribute attribute = best->type == CRIT_CLASS ? VIEW_CLASS
+		: best->type == CRIT_INSTANCE ? VIEW_INSTANCE : VIEW_APP_ID;
+	view_index_find(candidates, attribute, best->literal_value, best->literal == LITERAL_PREFIX);
+	if (best->literal == LITERAL_EXACT) {
+		char *newline = with_newline(best);
+		if (newline) {
+			view_index_find(candidates, attribute, newline, false);
+			free(newline);
+		}
+	}
+	return true;
+}
+
 list_t *container_for(list_t *tokens) {
-	struct list_tokens list_tokens = (struct list_tokens){create_list(), tokens};
+	struct list_tokens list_tokens = (struct list_tokens){create_list(), tokens, { 0 }};
 
-	container_map(&root_container, (void (*)(swayc_t *, void *))container_match_add, &list_tokens);
+	list_t *candidates = create_list();
+	if (indexed_candidates(tokens, candidates)) {
+		for (int i = 0; i < candidates->length; ++i) {
+			swayc_t *c = candidates->items[i];
+			if (swayc_in_tree(c)) {
+				container_match_add(c, &list_tokens);
+			}
+		}
+		container_sort_tree_order(list_tokens.list);
+	} else {
+		container_map(&root_container, (void (*)(swayc_t *, void *))container_match_add, &list_tokens);
+	}
+	list_free(candidates);
 	
+	// shown scratchpad views were matched in the tree already
 	for (int i = 0; i < scratchpad->length; ++i) {
 		swayc_t *c = scratchpad->items[i];
-		if (criteria_test(c, tokens)) {
+		if (!swayc_in_tree(c) && criteria_test(c, tokens, &list_tokens.focus)) {
 			list_add(list_tokens.list, c);
 		}
 	}
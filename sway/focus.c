@@ -8,6 +8,7 @@
 #include "sway/input_state.h"
 #include "sway/ipc-server.h"
 #include "sway/border.h"
+#include "sway/hit_index.h"
 #include "log.h"
 
 bool locked_container_focus = false;
@@ -23,6 +24,9 @@ static void update_focus(swayc_t *c) {
 		swayc_t *prev = parent->focused;
 		// Set new focus
 		parent->focused = c;
+		// pointer lookups follow the focus of tabbed/stacked containers
+		hit_index_invalidate(parent);
+		bump_tree_generation();
 
 		switch (c->type) {
 		// Shouldn't happen
@@ -134,6 +138,7 @@ bool set_focused_container(swayc_t *c) {
 
 	// update the global pointer
 	current_focus = c;
+	bump_tree_generation();
 
 	// update container focus from here to root, making necessary changes along
 	// the way
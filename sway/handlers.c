@@ -11,6 +11,7 @@
 #include <ctype.h>
 #include "sway/handlers.h"
 #include "sway/border.h"
+#include "sway/binding_index.h"
 #include "sway/layout.h"
 #include "sway/config.h"
 #include "sway/commands.h"
@@ -24,6 +25,8 @@
 #include "sway/ipc-server.h"
 #include "sway/input.h"
 #include "sway/security.h"
+#include "sway/hit_index.h"
+#include "intern.h"
 #include "list.h"
 #include "stringop.h"
 #include "log.h"
@@ -209,8 +212,13 @@ static void handle_output_destroyed(wlc_handle output) {
 	}
 }
 
+static void handle_output_pre_render(wlc_handle output) {
+	flush_arrange_windows();
+}
+
 static void handle_output_post_render(wlc_handle output) {
 	ipc_get_pixels(output);
+	ipc_capture_frames(output);
 }
 
 static void handle_view_pre_render(wlc_handle view) {
@@ -462,13 +470,18 @@ static bool handle_view_created(wlc_handle handle) {
 	suspend_workspace_cleanup = true;
 
 	if (newview) {
+		cache_feature_policy_mask(wlc_view_get_pid(handle));
 		ipc_event_window(newview, "new");
 		set_focused_container(newview);
 		wlc_view_set_mask(handle, VISIBLE);
 		swayc_t *output = swayc_parent_by_type(newview, C_OUTPUT);
-		arrange_windows(output, -1, -1);
+		schedule_arrange_windows(output);
 		// check if it matches for_window in config and execute if so
 		list_t *criteria = criteria_for(newview);
+		if (criteria->length > 0) {
+			// the for_window commands below see its geometry
+			flush_arrange_windows();
+		}
 		for (int i = 0; i < criteria->length; i++) {
 			struct criteria *crit = criteria->items[i];
 			sway_log(L_DEBUG, "for_window '%s' matches new view %p, cmd: '%s'",
@@ -482,6 +495,7 @@ static bool handle_view_created(wlc_handle handle) {
 			// refocus in-between command lists
 			set_focused_container(newview);
 		}
+		list_free(criteria);
 		swayc_t *workspace = swayc_parent_by_type(focused, C_WORKSPACE);
 		if (workspace && workspace->fullscreen) {
 			set_focused_container(workspace->fullscreen);
@@ -514,7 +528,7 @@ static bool handle_view_created(wlc_handle handle) {
 		set_focused_container(get_focused_container(current_ws));
 	}
 	if (prev_focus && prev_focus->type == C_VIEW
-			&& newview && criteria_any(newview, config->no_focus)) {
+			&& newview && criteria_any(newview, config->no_focus, &config->no_focus_index)) {
 		// Restore focus
 		swayc_t *ws = swayc_parent_by_type(newview, C_WORKSPACE);
 		if (!ws || ws != newview->parent
@@ -550,6 +564,7 @@ static void handle_view_destroyed(wlc_handle handle) {
 	}
 
 	if (view) {
+		uncache_feature_policy_mask(wlc_view_get_pid(handle));
 		bool fullscreen = swayc_is_fullscreen(view);
 		remove_view_from_scratchpad(view);
 		swayc_t *parent = destroy_view(view), *iter = NULL;
@@ -577,7 +592,7 @@ static void handle_view_destroyed(wlc_handle handle) {
 			}
 
 
-			arrange_windows(iter ? iter : parent, -1, -1);
+			schedule_arrange_windows(iter ? iter : parent);
 		}
 	} else {
 		// Is it unmanaged?
@@ -598,6 +613,7 @@ static void handle_view_destroyed(wlc_handle handle) {
 		for (i = 0; i < scratchpad->length; ++i) {
 			swayc_t *item = scratchpad->items[i];
 			if (item->handle == handle) {
+				uncache_feature_policy_mask(wlc_view_get_pid(handle));
 				list_del(scratchpad, i);
 				destroy_view(item);
 				break;
@@ -682,9 +698,13 @@ static void handle_view_properties_updated(wlc_handle view, uint32_t mask) {
 		const char *new_name = wlc_view_get_title(view);
 
 		if (new_name) {
-			if (!c->name || strcmp(c->name, new_name) != 0) {
-				free(c->name);
-				c->name = strdup(new_name);
+			char *name = (char *)intern_string(new_name);
+			if (c->name == name) {
+				intern_release(name);
+			} else {
+				intern_release(c->name);
+				c->name = name;
+				bump_tree_generation();
 				swayc_t *p = swayc_tabbed_stacked_ancestor(c);
 				if (p) {
 					// TODO: we only got the topmost tabbed/stacked container, update borders of all containers on the path
@@ -725,59 +745,6 @@ static void handle_binding_command(struct sway_binding *binding) {
 	free_cmd_results(res);
 }
 
-static bool handle_bindsym(struct sway_binding *binding, uint32_t keysym, uint32_t keycode) {
-	int i;
-	for (i = 0; i < binding->keys->length; ++i) {
-		if (binding->bindcode) {
-			xkb_keycode_t *key = binding->keys->items[i];
-			if (keycode == *key) {
-				handle_binding_command(binding);
-				return true;
-			}
-		} else {
-			xkb_keysym_t *key = binding->keys->items[i];
-			if (keysym == *key) {
-				handle_binding_command(binding);
-				return true;
-			}
-		}
-	}
-
-	return false;
-}
-
-static bool valid_bindsym(struct sway_binding *binding) {
-	bool match = false;
-	int i;
-	for (i = 0; i < binding->keys->length; ++i) {
-		if (binding->bindcode) {
-			xkb_keycode_t *key = binding->keys->items[i];
-			if ((match = check_key(0, *key)) == false) {
-				break;
-			}
-		} else {
-			xkb_keysym_t *key = binding->keys->items[i];
-			if ((match = check_key(*key, 0)) == false) {
-				break;
-			}
-		}
-	}
-
-	return match;
-}
-
-static bool handle_bindsym_release(struct sway_binding *binding) {
-	if (binding->keys->length == 1) {
-		xkb_keysym_t *key = binding->keys->items[0];
-		if (check_released_key(*key)) {
-			handle_binding_command(binding);
-			return true;
-		}
-	}
-
-	return false;
-}
-
 static bool handle_key(wlc_handle view, uint32_t time, const struct wlc_modifiers *modifiers,
 		uint32_t key, enum wlc_key_state state) {
 
@@ -821,38 +788,17 @@ static bool handle_key(wlc_handle view, uint32_t time, const struct wlc_modifier
 	modifiers_state_update(modifiers->mods);
 
 	// handle bindings
-	list_t *candidates = create_list();
-	for (i = 0; i < mode->bindings->length; ++i) {
-		struct sway_binding *binding = mode->bindings->items[i];
-		if ((modifiers->mods ^ binding->modifiers) == 0) {
-			switch (state) {
-			case WLC_KEY_STATE_PRESSED:
-				if (!binding->release && valid_bindsym(binding)) {
-					list_add(candidates, binding);
-				}
-				break;
-			case WLC_KEY_STATE_RELEASED:
-				if (binding->release && handle_bindsym_release(binding)) {
-					list_free(candidates);
-					return EVENT_HANDLED;
-				}
-				break;
-			}
-		}
+	struct sway_binding *binding;
+	if (state == WLC_KEY_STATE_PRESSED) {
+		binding = binding_index_key_pressed(mode, modifiers->mods, sym, key);
+	} else {
+		binding = binding_index_key_released(mode, modifiers->mods);
 	}
-
-	for (i = 0; i < candidates->length; ++i) {
-		struct sway_binding *binding = candidates->items[i];
-		if (state == WLC_KEY_STATE_PRESSED) {
-			if (!binding->release && handle_bindsym(binding, sym, key)) {
-				list_free(candidates);
-				return EVENT_HANDLED;
-			}
-		}
+	if (binding) {
+		handle_binding_command(binding);
+		return EVENT_HANDLED;
 	}
 
-	list_free(candidates);
-
 	swayc_t *focused = get_focused_container(&root_container);
 	if (focused->type == C_VIEW) {
 		pid_t pid = wlc_view_get_pid(focused->handle);
@@ -946,27 +892,19 @@ static bool swayc_border_check(swayc_t *c, const void *_origin) {
 static bool handle_pointer_button(wlc_handle view, uint32_t time, const struct wlc_modifiers *modifiers,
 		uint32_t button, enum wlc_button_state state, const struct wlc_point *origin) {
 
+	// geometry must be up to date before looking up what was clicked
+	flush_arrange_windows();
+
 	// Update view pointer is on
 	pointer_state.view = container_under_pointer();
 
 	struct sway_mode *mode = config->current_mode;
 	// handle bindings
-	for (int i = 0; i < mode->bindings->length; ++i) {
-		struct sway_binding *binding = mode->bindings->items[i];
-		if ((modifiers->mods ^ binding->modifiers) == 0) {
-			switch (state) {
-			case WLC_BUTTON_STATE_PRESSED:
-				if (!binding->release && handle_bindsym(binding, button, 0)) {
-					return EVENT_HANDLED;
-				}
-				break;
-			case WLC_BUTTON_STATE_RELEASED:
-				if (binding->release && handle_bindsym(binding, button, 0)) {
-					return EVENT_HANDLED;
-				}
-				break;
-			}
-		}
+	struct sway_binding *binding = binding_index_button(mode, modifiers->mods,
+			button, state == WLC_BUTTON_STATE_RELEASED);
+	if (binding) {
+		handle_binding_command(binding);
+		return EVENT_HANDLED;
 	}
 
 	// Update pointer_state
@@ -1034,7 +972,10 @@ static bool handle_pointer_button(wlc_handle view, uint32_t time, const struct w
 	if (pointer) {
 		swayc_t *ws = swayc_parent_by_type(focused, C_WORKSPACE);
 		if (ws != NULL) {
-				swayc_t *find = container_find(ws, &swayc_border_check, origin);
+				swayc_t *find;
+				if (!hit_index_title_bar_at(ws, origin->x, origin->y, &find)) {
+					find = container_find(ws, &swayc_border_check, origin);
+				}
 				if (find != NULL) {
 					set_focused_container(find);
 					return EVENT_HANDLED;
@@ -1051,6 +992,7 @@ static bool handle_pointer_button(wlc_handle view, uint32_t time, const struct w
 				if (pointer->parent->floating->items[i] == pointer) {
 					list_del(pointer->parent->floating, i);
 					list_add(pointer->parent->floating, pointer);
+					hit_index_invalidate(pointer);
 					break;
 				}
 			}
@@ -1125,6 +1067,7 @@ void register_wlc_handlers() {
 	wlc_set_output_destroyed_cb(handle_output_destroyed);
 	wlc_set_output_resolution_cb(handle_output_resolution_change);
 	wlc_set_output_focus_cb(handle_output_focused);
+	wlc_set_output_render_pre_cb(handle_output_pre_render);
 	wlc_set_output_render_post_cb(handle_output_post_render);
 	wlc_set_view_created_cb(handle_view_created);
 	wlc_set_view_destroyed_cb(handle_view_destroyed);
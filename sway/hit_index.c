@@ -0,0 +1,303 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "sway/container.h"
+#include "sway/hit_index.h"
+#include "log.h"
+
+// The grid always has HIT_GRID x HIT_GRID cells over the output, so large
+// outputs don't end up with more cells than small ones.
+#define HIT_GRID 32
+
+enum hit_entry_type {
+	HIT_TILED,
+	HIT_FLOATING,
+	HIT_TITLE_BAR,
+};
+
+struct hit_entry {
+	enum hit_entry_type type;
+	swayc_t *container;
+	// container_under_pointer picks the deepest tiled container
+	int depth;
+	double x, y, width, height;
+};
+
+struct hit_index {
+	bool dirty;
+	double width, height;
+
+	struct hit_entry *entries;
+	int length, capacity;
+
+	// entry indices of each cell, cell i owns items[cells[i]..cells[i + 1]]
+	int cells[HIT_GRID * HIT_GRID + 1];
+	int *items;
+	int items_capacity;
+};
+
+void hit_index_invalidate(swayc_t *container) {
+	while (container && container->type != C_WORKSPACE) {
+		container = container->parent;
+	}
+	if (container && container->hit_index) {
+		container->hit_index->dirty = true;
+	}
+}
+
+void hit_index_free(struct hit_index *index) {
+	if (!index) {
+		return;
+	}
+	free(index->entries);
+	free(index->items);
+	free(index);
+}
+
+static void add_entry(struct hit_index *index, enum hit_entry_type type,
+		swayc_t *container, int depth, double x, double y, double w, double h) {
+	if (w <= 0 || h <= 0) {
+		return;
+	}
+	if (index->length == index->capacity) {
+		int capacity = index->capacity ? index->capacity * 2 : 64;
+		struct hit_entry *entries = realloc(index->entries, capacity * sizeof(struct hit_entry));
+		if (!entries) {
+			sway_log(L_ERROR, "Unable to grow hit index");
+			return;
+		}
+		index->entries = entries;
+		index->capacity = capacity;
+	}
+	index->entries[index->length++] = (struct hit_entry){
+		.type = type, .container = container, .depth = depth,
+		.x = x, .y = y, .width = w, .height = h,
+	};
+}
+
+static void add_tiled(struct hit_index *index, swayc_t *container, int depth,
+		double x, double y, double w, double h) {
+	add_entry(index, HIT_TILED, container, depth, x, y, w, h);
+	if (container->type == C_VIEW) {
+		return;
+	}
+	if (container->layout == L_TABBED || container->layout == L_STACKED) {
+		// container_under_pointer descends into the focused child without
+		// looking at its geometry
+		if (container->focused) {
+			add_tiled(index, container->focused, depth + 1, x, y, w, h);
+		} else {
+			add_entry(index, HIT_TILED, NULL, depth + 1, x, y, w, h);
+		}
+		return;
+	}
+	for (int i = 0; i < container->children->length; ++i) {
+		swayc_t *child = container->children->items[i];
+		if (!child->visible) {
+			continue;
+		}
+		// only the part that is reachable through container counts
+		double x1 = fmax(x, child->x), y1 = fmax(y, child->y);
+		double x2 = fmin(x + w, child->x + child->width);
+		double y2 = fmin(y + h, child->y + child->height);
+		if (x2 > x1 && y2 > y1) {
+			add_tiled(index, child, depth + 1, x1, y1, x2 - x1, y2 - y1);
+		}
+	}
+}
+
+static void add_title_bars(struct hit_index *index, swayc_t *container) {
+	// same order as container_find
+	if (container->children == NULL || container->children->length == 0) {
+		return;
+	}
+	if (container->type == C_WORKSPACE) {
+		for (int i = 0; i < container->floating->length; ++i) {
+			swayc_t *child = container->floating->items[i];
+			if (child->border_type == B_NORMAL) {
+				struct wlc_geometry *g = &child->title_bar_geometry;
+				add_entry(index, HIT_TITLE_BAR, child, 0, g->origin.x, g->origin.y,
+						(int32_t)g->size.w, (int32_t)g->size.h);
+			}
+			add_title_bars(index, child);
+		}
+	}
+	for (int i = 0; i < container->children->length; ++i) {
+		swayc_t *child = container->children->items[i];
+		if (child->border_type == B_NORMAL) {
+			struct wlc_geometry *g = &child->title_bar_geometry;
+			add_entry(index, HIT_TITLE_BAR, child, 0, g->origin.x, g->origin.y,
+					(int32_t)g->size.w, (int32_t)g->size.h);
+		}
+		add_title_bars(index, child);
+	}
+}
+
+static int cell_column(struct hit_index *index, double x) {
+	int col = floor(x * HIT_GRID / index->width);
+	return col < 0 ? 0 : col >= HIT_GRID ? HIT_GRID - 1 : col;
+}
+
+static int cell_row(struct hit_index *index, double y) {
+	int row = floor(y * HIT_GRID / index->height);
+	return row < 0 ? 0 : row >= HIT_GRID ? HIT_GRID - 1 : row;
+}
+
+static bool build_cells(struct hit_index *index) {
+	memset(index->cells, 0, sizeof(index->cells));
+	// count the entries of each cell, shifted by one so that the prefix sum
+	// below yields start offsets
+	for (int i = 0; i < index->length; ++i) {
+		struct hit_entry *e = &index->entries[i];
+		int col1 = cell_column(index, e->x), col2 = cell_column(index, e->x + e->width);
+		int row1 = cell_row(index, e->y), row2 = cell_row(index, e->y + e->height);
+		for (int row = row1; row <= row2; ++row) {
+			for (int col = col1; col <= col2; ++col) {
+				index->cells[row * HIT_GRID + col + 1]++;
+			}
+		}
+	}
+	for (int i = 1; i <= HIT_GRID * HIT_GRID; ++i) {
+		index->cells[i] += index->cells[i - 1];
+	}
+
+	int total = index->cells[HIT_GRID * HIT_GRID];
+	if (total > index->items_capacity) {
+		int *items = realloc(index->items, total * sizeof(int));
+		if (!items) {
+			sway_log(L_ERROR, "Unable to grow hit index");
+			return false;
+		}
+		index->items = items;
+		index->items_capacity = total;
+	}
+
+	int fill[HIT_GRID * HIT_GRID];
+	memcpy(fill, index->cells, sizeof(fill));
+	// entries are added in order, so every cell ends up sorted by index
+	for (int i = 0; i < index->length; ++i) {
+		struct hit_entry *e = &index->entries[i];
+		int col1 = cell_column(index, e->x), col2 = cell_column(index, e->x + e->width);
+		int row1 = cell_row(index, e->y), row2 = cell_row(index, e->y + e->height);
+		for (int row = row1; row <= row2; ++row) {
+			for (int col = col1; col <= col2; ++col) {
+				index->items[fill[row * HIT_GRID + col]++] = i;
+			}
+		}
+	}
+	return true;
+}
+
+static struct hit_index *get_hit_index(swayc_t *workspace) {
+	if (!sway_assert(workspace->type == C_WORKSPACE, "Hit index requires a workspace")) {
+		return NULL;
+	}
+	struct hit_index *index = workspace->hit_index;
+	if (index && !index->dirty) {
+		return index;
+	}
+	if (!index) {
+		if (!(index = calloc(1, sizeof(struct hit_index)))) {
+			sway_log(L_ERROR, "Unable to allocate hit index");
+			return NULL;
+		}
+		workspace->hit_index = index;
+	}
+
+	swayc_t *output = workspace->parent;
+	index->width = output->width;
+	index->height = output->height;
+	index->length = 0;
+	index->dirty = true;
+	if (index->width <= 0 || index->height <= 0) {
+		return NULL;
+	}
+
+	for (int i = 0; i < workspace->floating->length; ++i) {
+		swayc_t *view = workspace->floating->items[i];
+		add_entry(index, HIT_FLOATING, view, 0, view->x, view->y, view->width, view->height);
+	}
+	for (int i = 0; i < workspace->children->length; ++i) {
+		swayc_t *child = workspace->children->items[i];
+		if (child->visible) {
+			add_tiled(index, child, 1, child->x, child->y, child->width, child->height);
+		}
+	}
+	add_title_bars(index, workspace);
+
+	if (!build_cells(index)) {
+		return NULL;
+	}
+	sway_log(L_DEBUG, "Rebuilt hit index of workspace %s with %d entries",
+			workspace->name, index->length);
+	index->dirty = false;
+	return index;
+}
+
+static bool entry_contains(struct hit_entry *e, double x, double y) {
+	return x >= e->x && y >= e->y && x < e->x + e->width && y < e->y + e->height;
+}
+
+/**
+ * Returns the entry indices of the cell containing x, y, or NULL if the point
+ * is outside of the output.
+ */
+static int *cell_items(struct hit_index *index, double x, double y, int *length) {
+	if (x < 0 || y < 0 || x >= index->width || y >= index->height) {
+		return NULL;
+	}
+	int cell = cell_row(index, y) * HIT_GRID + cell_column(index, x);
+	*length = index->cells[cell + 1] - index->cells[cell];
+	return index->items + index->cells[cell];
+}
+
+bool hit_index_container_at(swayc_t *workspace, double x, double y, swayc_t **result) {
+	struct hit_index *index = get_hit_index(workspace);
+	int length;
+	int *items;
+	if (!index || !(items = cell_items(index, x, y, &length))) {
+		return false;
+	}
+
+	// floating views are tested topmost (last) first
+	for (int i = length - 1; i >= 0; --i) {
+		struct hit_entry *e = &index->entries[items[i]];
+		if (e->type == HIT_FLOATING && e->container->visible
+				&& workspace->parent == root_container.focused
+				&& entry_contains(e, x, y)) {
+			*result = e->container;
+			return true;
+		}
+	}
+
+	struct hit_entry *best = NULL;
+	for (int i = 0; i < length; ++i) {
+		struct hit_entry *e = &index->entries[items[i]];
+		if (e->type == HIT_TILED && (!best || e->depth > best->depth)
+				&& entry_contains(e, x, y)) {
+			best = e;
+		}
+	}
+	*result = best ? best->container : workspace;
+	return true;
+}
+
+bool hit_index_title_bar_at(swayc_t *workspace, double x, double y, swayc_t **result) {
+	struct hit_index *index = get_hit_index(workspace);
+	int length;
+	int *items;
+	if (!index || !(items = cell_items(index, x, y, &length))) {
+		return false;
+	}
+
+	*result = NULL;
+	for (int i = 0; i < length; ++i) {
+		struct hit_entry *e = &index->entries[items[i]];
+		if (e->type == HIT_TITLE_BAR && entry_contains(e, x, y)) {
+			*result = e->container;
+			break;
+		}
+	}
+	return true;
+}
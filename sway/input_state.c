@@ -89,6 +89,11 @@ bool check_released_key(uint32_t key_sym) {
 		|| last_released.alt_sym == key_sym));
 }
 
+void get_released_key(uint32_t *key_sym, uint32_t *alt_sym) {
+	*key_sym = last_released.key_sym;
+	*alt_sym = last_released.alt_sym;
+}
+
 void press_key(uint32_t key_sym, uint32_t key_code) {
 	if (key_code == 0) {
 		return;
@@ -1,5 +1,10 @@
 #include <json-c/json.h>
 #include <ctype.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <libinput.h>
@@ -7,6 +12,7 @@
 #include "sway/input.h"
 #include "sway/ipc-json.h"
 #include "util.h"
+#include "log.h"
 
 static json_object *ipc_json_create_rect(swayc_t *c) {
 	json_object *rect = json_object_new_object();
@@ -39,10 +45,10 @@ static json_object *ipc_json_create_rect_from_geometry(struct wlc_geometry g) {
 	return rect;
 }
 
-static const char *ipc_json_border_description(swayc_t *c) {
+const char *ipc_json_border_description(enum swayc_border_types border_type) {
 	const char *border;
 
-	switch (c->border_type) {
+	switch (border_type) {
 	case B_PIXEL:
 		border = "1pixel";
 		break;
@@ -60,7 +66,7 @@ static const char *ipc_json_border_description(swayc_t *c) {
 	return border;
 }
 
-static const char *ipc_json_layout_description(enum swayc_layouts l) {
+const char *ipc_json_layout_description(enum swayc_layouts l) {
 	const char *layout;
 
 	switch (l) {
@@ -94,6 +100,26 @@ static const char *ipc_json_layout_description(enum swayc_layouts l) {
 	return layout;
 }
 
+const char *ipc_json_container_layout(swayc_t *c) {
+	const char *layout;
+	switch (c->type) {
+	case C_ROOT:
+		return "splith";
+	case C_OUTPUT:
+		return "output";
+	case C_WORKSPACE:
+		layout = ipc_json_layout_description(c->workspace_layout);
+		break;
+	default:
+		if (!c->parent || c->parent->type != C_CONTAINER) {
+			return "none";
+		}
+		layout = ipc_json_layout_description(c->parent->layout);
+		break;
+	}
+	return strcmp(layout, "null") == 0 ? NULL : layout;
+}
+
 static float ipc_json_child_percentage(swayc_t *c) {
 	float percent = 0;
 	swayc_t *parent = c->parent;
@@ -213,7 +239,7 @@ json_object *ipc_json_describe_container(swayc_t *c) {
 	json_object_object_add(object, "visible", json_object_new_boolean(c->visible));
 	json_object_object_add(object, "focused", json_object_new_boolean(c == current_focus));
 
-	json_object_object_add(object, "border", json_object_new_string(ipc_json_border_description(c)));
+	json_object_object_add(object, "border", json_object_new_string(ipc_json_border_description(c->border_type)));
 	json_object_object_add(object, "window_rect", ipc_json_create_rect_from_geometry(c->actual_geometry));
 	json_object_object_add(object, "deco_rect", ipc_json_create_rect_from_geometry(c->title_bar_geometry));
 	json_object_object_add(object, "geometry", ipc_json_create_rect_from_geometry(c->cached_geometry));
@@ -512,3 +538,462 @@ json_object *ipc_json_describe_container_recursive(swayc_t *c) {
 
 	return object;
 }
+
+/*
+ * Streaming serializers, writing the same bytes json_object_to_json_string
+ * produces for the objects built above without building them.
+ */
+
+static bool ipc_json_buffer_reserve(struct ipc_json_buffer *buf, size_t extra) {
+	if (buf->error) {
+		return false;
+	}
+	if (buf->size - buf->length >= extra) {
+		return true;
+	}
+	size_t size = buf->size ? buf->size : 4096;
+	while (size - buf->length < extra) {
+		size *= 2;
+	}
+	char *data = realloc(buf->data, size);
+	if (!data) {
+		sway_log(L_ERROR, "Unable to grow IPC reply buffer");
+		buf->error = true;
+		return false;
+	}
+	buf->data = data;
+	buf->size = size;
+	return true;
+}
+
+void ipc_json_buffer_init(struct ipc_json_buffer *buf, size_t reserved) {
+	buf->data = NULL;
+	buf->length = buf->size = 0;
+	buf->error = false;
+	if (ipc_json_buffer_reserve(buf, reserved)) {
+		buf->length = reserved;
+	}
+}
+
+static void ipc_json_append(struct ipc_json_buffer *buf, const char *str, size_t length) {
+	if (ipc_json_buffer_reserve(buf, length)) {
+		memcpy(buf->data + buf->length, str, length);
+		buf->length += length;
+	}
+}
+
+#define ipc_json_append_literal(buf, str) ipc_json_append(buf, str, sizeof(str) - 1)
+
+static void ipc_json_append_format(struct ipc_json_buffer *buf, const char *fmt, ...) {
+	char str[64];
+	va_list args;
+	va_start(args, fmt);
+	int length = vsnprintf(str, sizeof(str), fmt, args);
+	va_end(args);
+	if (length > 0) {
+		ipc_json_append(buf, str, (size_t)length < sizeof(str) ? (size_t)length : sizeof(str) - 1);
+	}
+}
+
+// same escaping as json-c, including the forward slash
+static void ipc_json_append_string(struct ipc_json_buffer *buf, const char *str) {
+	static const char hex[] = "0123456789abcdef";
+	ipc_json_append_literal(buf, "\"");
+	const char *start = str;
+	for (const char *p = str; *p; ++p) {
+		unsigned char c = *p;
+		const char *escape = NULL;
+		switch (c) {
+		case '\b': escape = "\\b"; break;
+		case '\n': escape = "\\n"; break;
+		case '\r': escape = "\\r"; break;
+		case '\t': escape = "\\t"; break;
+		case '\f': escape = "\\f"; break;
+		case '"': escape = "\\\""; break;
+		case '\\': escape = "\\\\"; break;
+		case '/': escape = "\\/"; break;
+		default:
+			if (c >= ' ') {
+				continue;
+			}
+		}
+		ipc_json_append(buf, start, p - start);
+		if (escape) {
+			ipc_json_append(buf, escape, strlen(escape));
+		} else {
+			char unicode[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+			ipc_json_append(buf, unicode, sizeof(unicode));
+		}
+		start = p + 1;
+	}
+	ipc_json_append(buf, start, strlen(start));
+	ipc_json_append_literal(buf, "\"");
+}
+
+static void ipc_json_append_string_or_null(struct ipc_json_buffer *buf, const char *str) {
+	if (str) {
+		ipc_json_append_string(buf, str);
+	} else {
+		ipc_json_append_literal(buf, "null");
+	}
+}
+
+static void ipc_json_append_int(struct ipc_json_buffer *buf, int32_t value) {
+	ipc_json_append_format(buf, "%" PRId32, value);
+}
+
+static void ipc_json_append_bool(struct ipc_json_buffer *buf, bool value) {
+	if (value) {
+		ipc_json_append_literal(buf, "true");
+	} else {
+		ipc_json_append_literal(buf, "false");
+	}
+}
+
+static void ipc_json_append_double(struct ipc_json_buffer *buf, double value) {
+	char str[128];
+	int length = snprintf(str, sizeof(str), "%.17g", value);
+	if (length < 0 || (size_t)length >= sizeof(str)) {
+		return;
+	}
+#if JSON_C_VERSION_NUM >= ((0 << 16) | (13 << 8))
+	// json-c 0.13 makes integral values look like floats
+	if ((size_t)length < sizeof(str) - 2 && isdigit((unsigned char)str[0])
+			&& !strchr(str, '.') && !strchr(str, 'e')) {
+		strcat(str, ".0");
+		length += 2;
+	}
+#endif
+	ipc_json_append(buf, str, length);
+}
+
+/**
+ * Starts the next member of an object (or element of an array if key is
+ * NULL), first is reset once the separator has been written.
+ */
+static void ipc_json_append_key(struct ipc_json_buffer *buf, bool *first, const char *key) {
+	if (*first) {
+		ipc_json_append_literal(buf, " ");
+		*first = false;
+	} else {
+		ipc_json_append_literal(buf, ", ");
+	}
+	if (key) {
+		ipc_json_append_literal(buf, "\"");
+		ipc_json_append(buf, key, strlen(key));
+		ipc_json_append_literal(buf, "\": ");
+	}
+}
+
+static void ipc_json_append_rect(struct ipc_json_buffer *buf,
+		int32_t x, int32_t y, int32_t width, int32_t height) {
+	ipc_json_append_format(buf, "{ \"x\": %" PRId32 ", \"y\": %" PRId32
+			", \"width\": %" PRId32 ", \"height\": %" PRId32 " }", x, y, width, height);
+}
+
+static void ipc_json_append_geometry(struct ipc_json_buffer *buf, struct wlc_geometry g) {
+	ipc_json_append_rect(buf, g.origin.x, g.origin.y, (int32_t)g.size.w, (int32_t)g.size.h);
+}
+
+static void ipc_json_append_layout(struct ipc_json_buffer *buf, const char *layout) {
+	ipc_json_append_string_or_null(buf, strcmp(layout, "null") == 0 ? NULL : layout);
+}
+
+/**
+ * Members of a container object being written: first as for
+ * ipc_json_append_key, and the keys to write if fields is not NULL.
+ */
+struct ipc_json_members {
+	bool first;
+	const char **fields;
+	int count;
+};
+
+/**
+ * Starts the member key if it was asked for, returns false (writing nothing)
+ * if it wasn't and the value is to be skipped.
+ */
+static bool ipc_json_append_member(struct ipc_json_buffer *buf,
+		struct ipc_json_members *members, const char *key) {
+	if (members->fields) {
+		int i = 0;
+		while (i < members->count && strcmp(members->fields[i], key) != 0) {
+			++i;
+		}
+		if (i == members->count) {
+			return false;
+		}
+	}
+	ipc_json_append_key(buf, &members->first, key);
+	return true;
+}
+
+static void ipc_json_append_view_members(struct ipc_json_buffer *buf,
+		struct ipc_json_members *members, swayc_t *c) {
+	if (ipc_json_append_member(buf, members, "type")) {
+		ipc_json_append_string(buf, c->is_floating ? "floating_con" : "con");
+	}
+	if (ipc_json_append_member(buf, members, "scratchpad_state")) {
+		ipc_json_append_string(buf, ipc_json_get_scratchpad_state(c));
+	}
+
+	if (ipc_json_append_member(buf, members, "window_properties")) {
+		wlc_handle parent = wlc_view_get_parent(c->handle);
+		bool props_first = true;
+		ipc_json_append_literal(buf, "{");
+		ipc_json_append_key(buf, &props_first, "class");
+		ipc_json_append_string_or_null(buf, c->class ? c->class : c->app_id);
+		ipc_json_append_key(buf, &props_first, "instance");
+		ipc_json_append_string_or_null(buf, c->instance ? c->instance : c->app_id);
+		ipc_json_append_key(buf, &props_first, "title");
+		ipc_json_append_string_or_null(buf, c->name);
+		ipc_json_append_key(buf, &props_first, "transient_for");
+		if (parent) {
+			ipc_json_append_int(buf, (int32_t)parent);
+		} else {
+			ipc_json_append_literal(buf, "null");
+		}
+		ipc_json_append_literal(buf, " }");
+	}
+
+	if (ipc_json_append_member(buf, members, "fullscreen_mode")) {
+		ipc_json_append_int(buf, swayc_is_fullscreen(c) ? 1 : 0);
+	}
+	if (ipc_json_append_member(buf, members, "sticky")) {
+		ipc_json_append_bool(buf, c->sticky);
+	}
+	if (ipc_json_append_member(buf, members, "floating")) {
+		ipc_json_append_string(buf, c->is_floating ? "auto_on" : "auto_off");
+	}
+	if (ipc_json_append_member(buf, members, "app_id")) {
+		ipc_json_append_string_or_null(buf, c->app_id);
+	}
+
+	if (c->parent) {
+		bool container = c->parent->type == C_CONTAINER;
+		if (ipc_json_append_member(buf, members, "layout")) {
+			ipc_json_append_layout(buf, container ?
+					ipc_json_layout_description(c->parent->layout) : "none");
+		}
+		if (ipc_json_append_member(buf, members, "last_split_layout")) {
+			ipc_json_append_layout(buf, container ?
+					ipc_json_layout_description(c->parent->prev_layout) : "none");
+		}
+		if (ipc_json_append_member(buf, members, "workspace_layout")) {
+			ipc_json_append_string(buf, ipc_json_layout_description(
+					swayc_parent_by_type(c, C_WORKSPACE)->workspace_layout));
+		}
+	}
+}
+
+/**
+ * Writes the members of ipc_json_describe_container(c), with focused moved to
+ * the end for get_workspaces, without the closing brace.
+ */
+static void ipc_json_append_container_members(struct ipc_json_buffer *buf,
+		struct ipc_json_members *members, swayc_t *c, bool workspace_reply) {
+	if (ipc_json_append_member(buf, members, "id")) {
+		ipc_json_append_int(buf, (int)c->id);
+	}
+	if (ipc_json_append_member(buf, members, "name")) {
+		ipc_json_append_string_or_null(buf, c->name);
+	}
+
+	if (ipc_json_append_member(buf, members, "rect")) {
+		struct wlc_size size;
+		if (c->type == C_OUTPUT) {
+			size = *wlc_output_get_resolution(c->handle);
+		} else {
+			size.w = c->width;
+			size.h = c->height;
+		}
+		ipc_json_append_rect(buf, (int32_t)c->x, (int32_t)c->y, (int32_t)size.w, (int32_t)size.h);
+	}
+
+	if (ipc_json_append_member(buf, members, "visible")) {
+		ipc_json_append_bool(buf, c->visible);
+	}
+	if (!workspace_reply && ipc_json_append_member(buf, members, "focused")) {
+		ipc_json_append_bool(buf, c == current_focus);
+	}
+	if (ipc_json_append_member(buf, members, "border")) {
+		ipc_json_append_string(buf, ipc_json_border_description(c->border_type));
+	}
+	if (ipc_json_append_member(buf, members, "window_rect")) {
+		ipc_json_append_geometry(buf, c->actual_geometry);
+	}
+	if (ipc_json_append_member(buf, members, "deco_rect")) {
+		ipc_json_append_geometry(buf, c->title_bar_geometry);
+	}
+	if (ipc_json_append_member(buf, members, "geometry")) {
+		ipc_json_append_geometry(buf, c->cached_geometry);
+	}
+	if (ipc_json_append_member(buf, members, "percent")) {
+		float percent = ipc_json_child_percentage(c);
+		if (percent > 0) {
+			ipc_json_append_double(buf, percent);
+		} else {
+			ipc_json_append_literal(buf, "null");
+		}
+	}
+	if (ipc_json_append_member(buf, members, "window")) {
+		ipc_json_append_int(buf, (int32_t)c->handle);
+	}
+	if (ipc_json_append_member(buf, members, "urgent")) {
+		ipc_json_append_bool(buf, false);
+	}
+	if (ipc_json_append_member(buf, members, "current_border_width")) {
+		ipc_json_append_int(buf, c->border_thickness);
+	}
+
+	switch (c->type) {
+	case C_ROOT:
+		if (ipc_json_append_member(buf, members, "type")) {
+			ipc_json_append_string(buf, "root");
+		}
+		if (ipc_json_append_member(buf, members, "layout")) {
+			ipc_json_append_string(buf, "splith");
+		}
+		break;
+
+	case C_OUTPUT:
+		if (ipc_json_append_member(buf, members, "active")) {
+			ipc_json_append_bool(buf, true);
+		}
+		if (ipc_json_append_member(buf, members, "primary")) {
+			ipc_json_append_bool(buf, false);
+		}
+		if (ipc_json_append_member(buf, members, "layout")) {
+			ipc_json_append_string(buf, "output");
+		}
+		if (ipc_json_append_member(buf, members, "type")) {
+			ipc_json_append_string(buf, "output");
+		}
+		if (ipc_json_append_member(buf, members, "current_workspace")) {
+			ipc_json_append_string_or_null(buf, c->focused ? c->focused->name : NULL);
+		}
+		if (ipc_json_append_member(buf, members, "scale")) {
+			ipc_json_append_int(buf, (int32_t)wlc_output_get_scale(c->handle));
+		}
+		break;
+
+	case C_CONTAINER: // fallthrough
+	case C_VIEW:
+		ipc_json_append_view_members(buf, members, c);
+		break;
+
+	case C_WORKSPACE:
+		if (ipc_json_append_member(buf, members, "num")) {
+			ipc_json_append_int(buf, isdigit(c->name[0]) ? atoi(c->name) : -1);
+		}
+		if (ipc_json_append_member(buf, members, "output")) {
+			ipc_json_append_string_or_null(buf, c->parent ? c->parent->name : NULL);
+		}
+		if (ipc_json_append_member(buf, members, "type")) {
+			ipc_json_append_string(buf, "workspace");
+		}
+		if (ipc_json_append_member(buf, members, "layout")) {
+			ipc_json_append_layout(buf, ipc_json_layout_description(c->workspace_layout));
+		}
+		break;
+
+	case C_TYPES: // fallthrough
+	default:
+		break;
+	}
+
+	if (workspace_reply && ipc_json_append_member(buf, members, "focused")) {
+		bool focused = root_container.focused == c->parent && c->parent->focused == c;
+		ipc_json_append_bool(buf, focused);
+	}
+}
+
+static void ipc_json_append_container_list(struct ipc_json_buffer *buf, list_t *list) {
+	bool first = true;
+	ipc_json_append_literal(buf, "[");
+	for (int i = 0; list && i < list->length; ++i) {
+		ipc_json_append_key(buf, &first, NULL);
+		ipc_json_write_tree(buf, list->items[i]);
+	}
+	ipc_json_append_literal(buf, " ]");
+}
+
+void ipc_json_write_tree(struct ipc_json_buffer *buf, swayc_t *c) {
+	struct ipc_json_members members = { true, NULL, 0 };
+	ipc_json_append_literal(buf, "{");
+	ipc_json_append_container_members(buf, &members, c, false);
+	bool first = members.first;
+
+	ipc_json_append_key(buf, &first, "floating_nodes");
+	ipc_json_append_container_list(buf, c->type != C_VIEW ? c->floating : NULL);
+	ipc_json_append_key(buf, &first, "nodes");
+	ipc_json_append_container_list(buf, c->type != C_VIEW ? c->children : NULL);
+
+	ipc_json_append_key(buf, &first, "focus");
+	bool focus_first = true;
+	ipc_json_append_literal(buf, "[");
+	if (c->type != C_VIEW) {
+		if (c->focused) {
+			ipc_json_append_key(buf, &focus_first, NULL);
+			ipc_json_append_double(buf, c->focused->id);
+		}
+		for (int i = 0; c->floating && i < c->floating->length; ++i) {
+			swayc_t *item = c->floating->items[i];
+			if (item != c->focused) {
+				ipc_json_append_key(buf, &focus_first, NULL);
+				ipc_json_append_double(buf, item->id);
+			}
+		}
+		for (int i = 0; c->children && i < c->children->length; ++i) {
+			swayc_t *item = c->children->items[i];
+			if (item != c->focused) {
+				ipc_json_append_key(buf, &focus_first, NULL);
+				ipc_json_append_double(buf, item->id);
+			}
+		}
+	}
+	ipc_json_append_literal(buf, " ]");
+
+	if (c->type == C_ROOT) {
+		ipc_json_append_key(buf, &first, "scratchpad");
+		ipc_json_append_container_list(buf, scratchpad);
+	}
+	ipc_json_append_literal(buf, " }");
+}
+
+struct workspaces_state {
+	struct ipc_json_buffer *buf;
+	bool first;
+};
+
+static void ipc_json_append_workspace(swayc_t *c, void *data) {
+	struct workspaces_state *state = data;
+	if (c->type == C_WORKSPACE) {
+		struct ipc_json_members members = { true, NULL, 0 };
+		ipc_json_append_key(state->buf, &state->first, NULL);
+		ipc_json_append_literal(state->buf, "{");
+		ipc_json_append_container_members(state->buf, &members, c, true);
+		ipc_json_append_literal(state->buf, " }");
+	}
+}
+
+void ipc_json_write_workspaces(struct ipc_json_buffer *buf) {
+	struct workspaces_state state = { buf, true };
+	ipc_json_append_literal(buf, "[");
+	container_map(&root_container, ipc_json_append_workspace, &state);
+	ipc_json_append_literal(buf, " ]");
+}
+
+void ipc_json_write_containers(struct ipc_json_buffer *buf, list_t *containers,
+		const char **fields, int count) {
+	bool first = true;
+	ipc_json_append_literal(buf, "[");
+	for (int i = 0; i < containers->length; ++i) {
+		struct ipc_json_members members = { true, fields, count };
+		ipc_json_append_key(buf, &first, NULL);
+		ipc_json_append_literal(buf, "{");
+		ipc_json_append_container_members(buf, &members, containers->items[i], false);
+		ipc_json_append_literal(buf, " }");
+	}
+	ipc_json_append_literal(buf, " ]");
+}
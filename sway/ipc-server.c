@@ -6,15 +6,19 @@
 #endif
 
 #include <errno.h>
+#include <inttypes.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <stdbool.h>
 #include <wlc/wlc-render.h>
 #include <unistd.h>
 #include <stdlib.h>
-#include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
 #include <json-c/json.h>
 #include <list.h>
 #include <libinput.h>
@@ -28,13 +32,19 @@ struct ucred {
 #include "sway/ipc-json.h"
 #include "sway/ipc-server.h"
 #include "sway/security.h"
+#include "sway/tree_diff.h"
+#include "sway/tree_snapshot.h"
+#include "ipc-capture.h"
 #include "sway/config.h"
 #include "sway/commands.h"
+#include "sway/criteria.h"
+#include "sway/mark_index.h"
 #include "sway/input.h"
 #include "stringop.h"
 #include "log.h"
 #include "list.h"
 #include "util.h"
+#include "shm.h"
 
 static int ipc_socket = -1;
 static struct wlc_event_source *ipc_event_source =  NULL;
@@ -46,22 +56,124 @@ static const char ipc_magic[] = {'i', '3', '-', 'i', 'p', 'c'};
 struct ipc_client {
 	struct wlc_event_source *event_source;
 	struct wlc_event_source *writable_event_source;
+	// fires when messages were left in read_buffer by the per wakeup limit
+	struct wlc_event_source *backlog_event_source;
 	int fd;
 	uint32_t payload_length;
 	uint32_t security_policy;
 	enum ipc_command_type current_command;
 	enum ipc_command_type subscribed_events;
-	size_t write_buffer_len;
-	size_t write_buffer_size;
-	char *write_buffer;
+	// received bytes, read_offset of them have been handled already
+	char *read_buffer;
+	size_t read_buffer_size;
+	size_t read_buffer_len;
+	size_t read_offset;
+	// ring of messages waiting to be written, the first one has
+	// write_offset bytes written already
+	struct ipc_message **write_queue;
+	size_t write_queue_capacity;
+	size_t write_queue_head;
+	size_t write_queue_length;
+	size_t write_offset;
+	size_t write_queue_bytes;
+	// milliseconds coalescable events are held back and merged, 0 sends
+	// them right away
+	uint32_t coalesce_interval;
+	// struct ipc_coalesced_event, in the order they were first held back
+	list_t *coalesced;
+	struct wlc_event_source *coalesce_event_source;
+	// shared memory get_pixels requests with "shm" are answered in, the
+	// client got a descriptor of it with the first such reply
+	char *pixels_map;
+	size_t pixels_size;
+	struct ipc_capture *capture;
 };
 
+/**
+ * Identifies events that supersede each other, like the title changes of one
+ * window. change must be a string literal.
+ */
+struct ipc_event_key {
+	enum ipc_command_type event;
+	size_t id;
+	const char *change;
+};
+
+struct ipc_coalesced_event {
+	struct ipc_event_key key;
+	// the latest event and how many were dropped in favour of it
+	struct ipc_message *message;
+	uint32_t merged;
+};
+
+/**
+ * A serialized message (header and payload). Events are serialized once and
+ * the same message is queued on every subscribed client. data usually points
+ * to inline_data, streamed replies hand over their own buffer.
+ */
+struct ipc_message {
+	unsigned int refcount;
+	size_t size;
+	char *data;
+	// sent along with the first byte of the message, -1 if there is none
+	int fd;
+	char inline_data[];
+};
+
+// TODO: reduce the limit back to 4 MB when screenshooter is implemented
+static const size_t ipc_client_queue_limit = 1 << 28; // 256 MB
+
+// Messages handled per client and wakeup, so a client pipelining lots of
+// requests can't hold up input handling.
+static const int ipc_client_messages_per_wakeup = 16;
+static const size_t ipc_client_read_size = 16384;
+
 static list_t *ipc_get_pixel_requests = NULL;
 
+/**
+ * Last reply to each read-only query and the tree generation it was
+ * serialized at, handed out again as long as the tree didn't change.
+ */
+struct ipc_reply_cache {
+	uint64_t generation;
+	struct ipc_message *message;
+};
+
+static struct ipc_reply_cache ipc_reply_cache[4];
+
+/**
+ * Snapshot the tree event is diffed against, only kept while someone is
+ * subscribed, and the shared memory snapshot, kept once someone asked for it.
+ * Changes are collected for a millisecond so that a command touching many
+ * containers results in a single update.
+ */
+static struct tree_diff *ipc_tree_diff = NULL;
+static struct tree_snapshot *ipc_tree_snapshot = NULL;
+static struct wlc_event_source *ipc_tree_timer = NULL;
+static bool ipc_tree_pending = false;
+
+// buffers are tracked in a 32 bit mask, a few are plenty for recording
+static const uint32_t ipc_capture_max_buffers = 8;
+
+struct ipc_capture {
+	wlc_handle output;
+	struct wlc_geometry geo;
+	// buffers of buffer_size bytes each, shared with the client
+	char *map;
+	size_t buffer_size;
+	uint32_t buffers;
+	// bit n is set while buffer n is with the client
+	uint32_t busy;
+	uint32_t sequence;
+	uint32_t skipped;
+};
+
 struct get_pixels_request {
 	struct ipc_client *client;
 	wlc_handle output;
 	struct wlc_geometry geo;
+	// answer in the shared memory buffer of the client
+	bool shm;
 };
 
 struct get_clipboard_request {
@@ -81,12 +193,23 @@ struct sockaddr_un *ipc_user_sockaddr(void);
 int ipc_handle_connection(int fd, uint32_t mask, void *data);
 int ipc_client_handle_readable(int client_fd, uint32_t mask, void *data);
 int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data);
+static int ipc_client_handle_backlog(void *data);
 void ipc_client_disconnect(struct ipc_client *client);
-void ipc_client_handle_command(struct ipc_client *client);
+void ipc_client_handle_command(struct ipc_client *client, char *buf);
 bool ipc_send_reply(struct ipc_client *client, const char *payload, uint32_t payload_length);
-void ipc_get_workspaces_callback(swayc_t *workspace, void *data);
+static void ipc_message_unref(struct ipc_message *message);
+static struct ipc_message *ipc_message_from_json_buffer(enum ipc_command_type type,
+		struct ipc_json_buffer *buf);
+static bool ipc_send_message(struct ipc_client *client, struct ipc_message *message);
+static bool ipc_send_cacheable_reply(struct ipc_client *client, struct ipc_message *message);
+static bool ipc_send_cached_reply(struct ipc_client *client);
 void ipc_get_outputs_callback(swayc_t *container, void *data);
-static void ipc_get_marks_callback(swayc_t *container, void *data);
+static void ipc_get_containers(struct ipc_client *client, const char *buf);
+static bool ipc_client_set_coalesce_interval(struct ipc_client *client, uint32_t interval);
+static swayc_t *ipc_parse_pixels_request(json_object *obj, struct wlc_geometry *g);
+static void ipc_capture_request(struct ipc_client *client, const char *buf);
+static void ipc_capture_free(struct ipc_capture *capture);
+static void ipc_get_marks_callback(const char *mark, swayc_t *container, void *data);
 
 void ipc_init(void) {
 	ipc_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
@@ -130,6 +253,22 @@ void ipc_terminate(void) {
 
 	list_free(ipc_client_list);
 
+	for (size_t i = 0; i < sizeof(ipc_reply_cache) / sizeof(ipc_reply_cache[0]); ++i) {
+		if (ipc_reply_cache[i].message) {
+			ipc_message_unref(ipc_reply_cache[i].message);
+			ipc_reply_cache[i].message = NULL;
+		}
+	}
+
+	if (ipc_tree_timer) {
+		wlc_event_source_remove(ipc_tree_timer);
+		ipc_tree_timer = NULL;
+	}
+	tree_diff_free(ipc_tree_diff);
+	ipc_tree_diff = NULL;
+	tree_snapshot_free(ipc_tree_snapshot);
+	ipc_tree_snapshot = NULL;
+
 	if (ipc_sockaddr) {
 		free(ipc_sockaddr);
 	}
@@ -209,15 +348,27 @@ int ipc_handle_connection(int fd, uint32_t mask, void *data) {
 	client->subscribed_events = 0;
 	client->event_source = wlc_event_loop_add_fd(client_fd, WLC_EVENT_READABLE, ipc_client_handle_readable, client);
 	client->writable_event_source = NULL;
+	client->backlog_event_source = NULL;
 
-	client->write_buffer_size = 128;
-	client->write_buffer_len = 0;
-	client->write_buffer = malloc(client->write_buffer_size);
-	if (!client->write_buffer) {
-		sway_log(L_ERROR, "Unable to allocate ipc client write buffer");
-		close(client_fd);
-		return 0;
-	}
+	client->read_buffer = NULL;
+	client->read_buffer_size = 0;
+	client->read_buffer_len = 0;
+	client->read_offset = 0;
+
+	client->write_queue = NULL;
+	client->write_queue_capacity = 0;
+	client->write_queue_head = 0;
+	client->write_queue_length = 0;
+	client->write_offset = 0;
+	client->write_queue_bytes = 0;
+
+	client->coalesce_interval = 0;
+	client->coalesced = NULL;
+	client->coalesce_event_source = NULL;
+
+	client->pixels_map = NULL;
+	client->pixels_size = 0;
+	client->capture = NULL;
 
 	pid_t pid = get_client_pid(client->fd);
 	client->security_policy = get_ipc_policy_mask(pid);
@@ -231,69 +382,282 @@ int ipc_handle_connection(int fd, uint32_t mask, void *data) {
 
 static const int ipc_header_size = sizeof(ipc_magic)+8;
 
-int ipc_client_handle_readable(int client_fd, uint32_t mask, void *data) {
-	struct ipc_client *client = data;
+static struct ipc_message *ipc_message_create(enum ipc_command_type type,
+		const char *payload, uint32_t payload_length) {
+	struct ipc_message *message = malloc(sizeof(struct ipc_message) + ipc_header_size + payload_length);
+	if (!message) {
+		return NULL;
+	}
+	message->refcount = 1;
+	message->size = ipc_header_size + payload_length;
+	message->data = message->inline_data;
+	message->fd = -1;
+
+	uint32_t header[2] = { payload_length, type };
+	memcpy(message->data, ipc_magic, sizeof(ipc_magic));
+	memcpy(message->data + sizeof(ipc_magic), header, sizeof(header));
+	memcpy(message->data + ipc_header_size, payload, payload_length);
+	return message;
+}
 
-	if (mask & WLC_EVENT_ERROR) {
-		sway_log(L_ERROR, "IPC Client socket error, removing client");
-		ipc_client_disconnect(client);
-		return 0;
+/**
+ * Turns a buffer starting with ipc_header_size unused bytes followed by the
+ * payload into a message, taking ownership of the buffer.
+ */
+static struct ipc_message *ipc_message_adopt(enum ipc_command_type type,
+		char *buffer, size_t size) {
+	struct ipc_message *message = malloc(sizeof(struct ipc_message));
+	if (!message) {
+		free(buffer);
+		return NULL;
+	}
+	message->refcount = 1;
+	message->size = size;
+	message->data = buffer;
+	message->fd = -1;
+
+	uint32_t header[2] = { size - ipc_header_size, type };
+	memcpy(message->data, ipc_magic, sizeof(ipc_magic));
+	memcpy(message->data + sizeof(ipc_magic), header, sizeof(header));
+	return message;
+}
+
+static void ipc_message_unref(struct ipc_message *message) {
+	if (--message->refcount == 0) {
+		if (message->fd != -1) {
+			close(message->fd);
+		}
+		if (message->data != message->inline_data) {
+			free(message->data);
+		}
+		free(message);
 	}
+}
 
-	if (mask & WLC_EVENT_HANGUP) {
-		sway_log(L_DEBUG, "Client %d hung up", client->fd);
-		ipc_client_disconnect(client);
-		return 0;
+static struct ipc_reply_cache *ipc_reply_cache_slot(enum ipc_command_type type) {
+	switch (type) {
+	case IPC_GET_WORKSPACES:
+		return &ipc_reply_cache[0];
+	case IPC_GET_OUTPUTS:
+		return &ipc_reply_cache[1];
+	case IPC_GET_TREE:
+		return &ipc_reply_cache[2];
+	case IPC_GET_MARKS:
+		return &ipc_reply_cache[3];
+	default:
+		return NULL;
 	}
+}
 
-	sway_log(L_DEBUG, "Client %d readable", client->fd);
+/**
+ * Returns the cached reply to type if the tree didn't change since it was
+ * serialized, or NULL.
+ */
+static struct ipc_message *ipc_reply_cache_get(enum ipc_command_type type) {
+	struct ipc_reply_cache *cache = ipc_reply_cache_slot(type);
+	if (cache && cache->message && cache->generation == get_tree_generation()) {
+		return cache->message;
+	}
+	return NULL;
+}
 
-	int read_available;
-	if (ioctl(client_fd, FIONREAD, &read_available) == -1) {
-		sway_log_errno(L_INFO, "Unable to read IPC socket buffer size");
-		ipc_client_disconnect(client);
-		return 0;
+static void ipc_reply_cache_set(enum ipc_command_type type, struct ipc_message *message,
+		uint64_t generation) {
+	struct ipc_reply_cache *cache = ipc_reply_cache_slot(type);
+	if (!cache) {
+		return;
 	}
+	if (cache->message) {
+		ipc_message_unref(cache->message);
+	}
+	message->refcount++;
+	cache->message = message;
+	cache->generation = generation;
+}
 
-	// Wait for the rest of the command payload in case the header has already been read
-	if (client->payload_length > 0) {
-		if ((uint32_t)read_available >= client->payload_length) {
-			ipc_client_handle_command(client);
+static struct ipc_message *ipc_client_queue_peek(struct ipc_client *client, size_t i) {
+	return client->write_queue[(client->write_queue_head + i) % client->write_queue_capacity];
+}
+
+/**
+ * Adds a reference to message to the write queue of client.
+ */
+static bool ipc_client_queue(struct ipc_client *client, struct ipc_message *message) {
+	if (client->write_queue_bytes + message->size > ipc_client_queue_limit) {
+		sway_log(L_ERROR, "Client write queue too big, disconnecting client");
+		return false;
+	}
+
+	if (client->write_queue_length == client->write_queue_capacity) {
+		size_t capacity = client->write_queue_capacity ? client->write_queue_capacity * 2 : 8;
+		struct ipc_message **queue = malloc(capacity * sizeof(struct ipc_message *));
+		if (!queue) {
+			sway_log(L_ERROR, "Unable to grow ipc client write queue");
+			return false;
 		}
-		return 0;
+		for (size_t i = 0; i < client->write_queue_length; ++i) {
+			queue[i] = ipc_client_queue_peek(client, i);
+		}
+		free(client->write_queue);
+		client->write_queue = queue;
+		client->write_queue_capacity = capacity;
+		client->write_queue_head = 0;
 	}
 
-	if (read_available < ipc_header_size) {
-		return 0;
+	size_t tail = (client->write_queue_head + client->write_queue_length) % client->write_queue_capacity;
+	client->write_queue[tail] = message;
+	client->write_queue_length++;
+	client->write_queue_bytes += message->size;
+	message->refcount++;
+
+	if (!client->writable_event_source) {
+		client->writable_event_source = wlc_event_loop_add_fd(client->fd, WLC_EVENT_WRITABLE, ipc_client_handle_writable, client);
 	}
+	return true;
+}
 
-	uint8_t buf[ipc_header_size];
-	uint32_t *buf32 = (uint32_t*)(buf + sizeof(ipc_magic));
-	// Should be fully available, because read_available >= ipc_header_size
-	ssize_t received = recv(client_fd, buf, ipc_header_size, 0);
-	if (received == -1) {
-		sway_log_errno(L_INFO, "Unable to receive header from IPC client");
-		ipc_client_disconnect(client);
-		return 0;
+/**
+ * Drops written bytes from the front of the write queue of client.
+ */
+static void ipc_client_queue_consume(struct ipc_client *client, size_t written) {
+	client->write_queue_bytes -= written;
+	while (written > 0) {
+		struct ipc_message *message = ipc_client_queue_peek(client, 0);
+		size_t remaining = message->size - client->write_offset;
+		if (written < remaining) {
+			client->write_offset += written;
+			return;
+		}
+		written -= remaining;
+		client->write_offset = 0;
+		client->write_queue_head = (client->write_queue_head + 1) % client->write_queue_capacity;
+		client->write_queue_length--;
+		ipc_message_unref(message);
 	}
+}
 
-	if (memcmp(buf, ipc_magic, sizeof(ipc_magic)) != 0) {
-		sway_log(L_DEBUG, "IPC header check failed");
-		ipc_client_disconnect(client);
-		return 0;
+static bool ipc_client_alive(struct ipc_client *client) {
+	for (int i = 0; i < ipc_client_list->length; ++i) {
+		if (ipc_client_list->items[i] == client) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Makes room for at least extra more bytes in the read buffer of client,
+ * dropping the bytes that were handled already.
+ */
+static bool ipc_client_read_buffer_reserve(struct ipc_client *client, size_t extra) {
+	if (client->read_offset > 0) {
+		memmove(client->read_buffer, client->read_buffer + client->read_offset,
+				client->read_buffer_len - client->read_offset);
+		client->read_buffer_len -= client->read_offset;
+		client->read_offset = 0;
+	}
+	if (client->read_buffer_size - client->read_buffer_len >= extra) {
+		return true;
+	}
+	size_t size = client->read_buffer_size ? client->read_buffer_size : ipc_client_read_size;
+	while (size - client->read_buffer_len < extra) {
+		size *= 2;
+	}
+	if (size > ipc_client_queue_limit) {
+		sway_log(L_ERROR, "Client read buffer too big, disconnecting client");
+		return false;
+	}
+	char *buffer = realloc(client->read_buffer, size);
+	if (!buffer) {
+		sway_log(L_ERROR, "Unable to grow ipc client read buffer");
+		return false;
+	}
+	client->read_buffer = buffer;
+	client->read_buffer_size = size;
+	return true;
+}
+
+/**
+ * Handles the complete messages in the read buffer of client, up to
+ * ipc_client_messages_per_wakeup of them unless drain is set. Returns false
+ * if the client was disconnected.
+ */
+static bool ipc_client_handle_messages(struct ipc_client *client, bool drain) {
+	int handled = 0;
+	while (client->read_buffer_len - client->read_offset >= (size_t)ipc_header_size) {
+		if (!drain && handled == ipc_client_messages_per_wakeup) {
+			// the socket may have nothing left to read, come back on our own
+			if (!client->backlog_event_source) {
+				client->backlog_event_source = wlc_event_loop_add_timer(ipc_client_handle_backlog, client);
+			}
+			if (client->backlog_event_source) {
+				wlc_event_source_timer_update(client->backlog_event_source, 1);
+			}
+			return true;
+		}
+
+		char *header = client->read_buffer + client->read_offset;
+		if (memcmp(header, ipc_magic, sizeof(ipc_magic)) != 0) {
+			sway_log(L_DEBUG, "IPC header check failed");
+			ipc_client_disconnect(client);
+			return false;
+		}
+		uint32_t header32[2];
+		memcpy(header32, header + sizeof(ipc_magic), sizeof(header32));
+		size_t message_size = ipc_header_size + (size_t)header32[0];
+		if (client->read_buffer_len - client->read_offset < message_size) {
+			// make sure the rest of the message fits in the buffer
+			if (!ipc_client_read_buffer_reserve(client, message_size + 1)) {
+				ipc_client_disconnect(client);
+				return false;
+			}
+			break;
+		}
+
+		client->payload_length = header32[0];
+		client->current_command = (enum ipc_command_type)header32[1];
+		client->read_offset += message_size;
+
+		// the payload is terminated in place, the byte after it belongs to
+		// the next message (or is spare) and is restored afterwards
+		char *payload = header + ipc_header_size;
+		char next = payload[client->payload_length];
+		payload[client->payload_length] = '\0';
+		ipc_client_handle_command(client, payload);
+		if (!ipc_client_alive(client)) {
+			return false;
+		}
+		payload[client->payload_length] = next;
+		client->payload_length = 0;
+		handled++;
 	}
 
-	client->payload_length = buf32[0];
-	client->current_command = (enum ipc_command_type)buf32[1];
+	if (client->read_offset == client->read_buffer_len) {
+		client->read_buffer_len = client->read_offset = 0;
+	}
+	return true;
+}
 
-	if (read_available - received >= (long)client->payload_length) {
-		ipc_client_handle_command(client);
+/**
+ * Whether the read buffer of client holds a complete message that was not
+ * handled yet.
+ */
+static bool ipc_client_has_message(struct ipc_client *client) {
+	size_t pending = client->read_buffer_len - client->read_offset;
+	if (pending < (size_t)ipc_header_size) {
+		return false;
 	}
+	uint32_t length;
+	memcpy(&length, client->read_buffer + client->read_offset + sizeof(ipc_magic), sizeof(length));
+	return pending >= ipc_header_size + (size_t)length;
+}
 
+static int ipc_client_handle_backlog(void *data) {
+	ipc_client_handle_messages(data, false);
 	return 0;
 }
 
-int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data) {
+int ipc_client_handle_readable(int client_fd, uint32_t mask, void *data) {
 	struct ipc_client *client = data;
 
 	if (mask & WLC_EVENT_ERROR) {
@@ -302,19 +666,106 @@ int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data) {
 		return 0;
 	}
 
-	if (mask & WLC_EVENT_HANGUP) {
+	// a client that hung up may still have sent requests, including ones
+	// waiting for the backlog timer, they are read and handled below
+	bool hangup = mask & WLC_EVENT_HANGUP;
+	if (hangup) {
 		sway_log(L_DEBUG, "Client %d hung up", client->fd);
+	} else {
+		sway_log(L_DEBUG, "Client %d readable", client->fd);
+	}
+
+	bool eof = false;
+	// leave what we can't handle yet in the socket, so that a client sending
+	// faster than we handle requests blocks instead of growing our buffer
+	while (hangup || !ipc_client_has_message(client)) {
+		// keep a byte after the received data to terminate the last payload
+		if (client->read_buffer_size - client->read_buffer_len < ipc_client_read_size + 1) {
+			if (!ipc_client_read_buffer_reserve(client, ipc_client_read_size + 1)) {
+				ipc_client_disconnect(client);
+				return 0;
+			}
+		}
+		size_t space = client->read_buffer_size - client->read_buffer_len - 1;
+		ssize_t received = recv(client_fd, client->read_buffer + client->read_buffer_len, space, 0);
+		if (received == -1 && errno == EINTR) {
+			continue;
+		} else if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			eof = hangup;
+			break;
+		} else if (received == -1) {
+			sway_log_errno(L_INFO, "Unable to receive data from IPC client");
+			ipc_client_disconnect(client);
+			return 0;
+		} else if (received == 0) {
+			eof = true;
+			break;
+		}
+		client->read_buffer_len += received;
+		if (!hangup && (size_t)received < space) {
+			break;
+		}
+	}
+
+	// a client that closed its end won't wake us up again, handle everything
+	// it sent before letting it go
+	if (!ipc_client_handle_messages(client, eof)) {
+		return 0;
+	}
+	if (eof) {
+		sway_log(L_DEBUG, "Client %d closed the connection", client->fd);
+		ipc_client_disconnect(client);
+	}
+	return 0;
+}
+
+int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data) {
+	struct ipc_client *client = data;
+
+	if (mask & WLC_EVENT_ERROR) {
+		sway_log(L_ERROR, "IPC Client socket error, removing client");
 		ipc_client_disconnect(client);
 		return 0;
 	}
 
-	if (client->write_buffer_len <= 0) {
+	if (mask & WLC_EVENT_HANGUP) {
+		// nothing can be written anymore, but what it sent is still handled
+		return ipc_client_handle_readable(client_fd, mask, data);
+	}
+
+	if (client->write_queue_length == 0) {
 		return 0;
 	}
 
 	sway_log(L_DEBUG, "Client %d writable", client->fd);
 
-	ssize_t written = write(client->fd, client->write_buffer, client->write_buffer_len);
+	struct iovec iov[64];
+	int iovcnt = 0;
+	for (size_t i = 0; i < client->write_queue_length && iovcnt < 64; ++i) {
+		struct ipc_message *message = ipc_client_queue_peek(client, i);
+		if (i > 0 && message->fd != -1) {
+			// descriptors have to start a write of their own
+			break;
+		}
+		size_t offset = i == 0 ? client->write_offset : 0;
+		iov[iovcnt].iov_base = message->data + offset;
+		iov[iovcnt].iov_len = message->size - offset;
+		iovcnt++;
+	}
+	struct msghdr msg = { .msg_iov = iov, .msg_iovlen = iovcnt };
+	char control[CMSG_SPACE(sizeof(int))];
+	struct ipc_message *head = ipc_client_queue_peek(client, 0);
+	if (head->fd != -1 && client->write_offset == 0) {
+		memset(control, 0, sizeof(control));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(cmsg), &head->fd, sizeof(int));
+	}
+	ssize_t written = sendmsg(client->fd, &msg, 0);
 
 	if (written == -1 && errno == EAGAIN) {
 		return 0;
@@ -324,10 +775,9 @@ int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data) {
 		return 0;
 	}
 
-	memmove(client->write_buffer, client->write_buffer + written, client->write_buffer_len - written);
-	client->write_buffer_len -= written;
+	ipc_client_queue_consume(client, written);
 
-	if (client->write_buffer_len == 0 && client->writable_event_source) {
+	if (client->write_queue_length == 0 && client->writable_event_source) {
 		wlc_event_source_remove(client->writable_event_source);
 		client->writable_event_source = NULL;
 	}
@@ -349,10 +799,40 @@ void ipc_client_disconnect(struct ipc_client *client) {
 	if (client->writable_event_source) {
 		wlc_event_source_remove(client->writable_event_source);
 	}
+	if (client->backlog_event_source) {
+		wlc_event_source_remove(client->backlog_event_source);
+	}
+	if (client->coalesce_event_source) {
+		wlc_event_source_remove(client->coalesce_event_source);
+	}
+	if (client->coalesced) {
+		for (int i = 0; i < client->coalesced->length; ++i) {
+			struct ipc_coalesced_event *pending = client->coalesced->items[i];
+			ipc_message_unref(pending->message);
+			free(pending);
+		}
+		list_free(client->coalesced);
+	}
+	if (client->pixels_map) {
+		munmap(client->pixels_map, client->pixels_size);
+	}
+	ipc_capture_free(client->capture);
+	// pending get_pixels requests would write to the freed client
+	for (int i = 0; i < ipc_get_pixel_requests->length; ++i) {
+		struct get_pixels_request *req = ipc_get_pixel_requests->items[i];
+		if (req->client == client) {
+			list_del(ipc_get_pixel_requests, i--);
+			free(req);
+		}
+	}
 	int i = 0;
 	while (i < ipc_client_list->length && ipc_client_list->items[i] != client) i++;
 	list_del(ipc_client_list, i);
-	free(client->write_buffer);
+	for (size_t i = 0; i < client->write_queue_length; ++i) {
+		ipc_message_unref(ipc_client_queue_peek(client, i));
+	}
+	free(client->write_queue);
+	free(client->read_buffer);
 	close(client->fd);
 	free(client);
 }
@@ -365,19 +845,314 @@ bool output_by_name_test(swayc_t *view, void *data) {
 	return !strcmp(name, view->name);
 }
 
+/**
+ * Limits a [start, start + length) range to [0, max). Returns the length left,
+ * 0 if nothing was left or length was negative.
+ */
+static uint32_t clamp_range(int start, int length, uint32_t max, int32_t *out_start) {
+	int64_t begin = start, end = (int64_t)start + length;
+	if (length <= 0 || end <= 0 || begin >= max) {
+		*out_start = 0;
+		return 0;
+	}
+	begin = begin < 0 ? 0 : begin;
+	end = end > max ? max : end;
+	*out_start = (int32_t)begin;
+	return (uint32_t)(end - begin);
+}
+
+/**
+ * Reads the output name and area of a get_pixels or capture request. Returns
+ * the output, or NULL if there is no output of that name. The area is clipped
+ * to the output's resolution, it is empty if nothing of it was on the output.
+ */
+static swayc_t *ipc_parse_pixels_request(json_object *obj, struct wlc_geometry *g) {
+	json_object *o = NULL, *x = NULL, *y = NULL, *w = NULL, *h = NULL;
+	json_object_object_get_ex(obj, "output", &o);
+	json_object_object_get_ex(obj, "x", &x);
+	json_object_object_get_ex(obj, "y", &y);
+	json_object_object_get_ex(obj, "w", &w);
+	json_object_object_get_ex(obj, "h", &h);
+
+	*g = (struct wlc_geometry){ .origin = { 0, 0 }, .size = { 0, 0 } };
+	if (!o) {
+		return NULL;
+	}
+	swayc_t *output = swayc_by_test(&root_container, output_by_name_test,
+			(void *)json_object_get_string(o));
+	if (!output) {
+		return NULL;
+	}
+	// pixels are read from the framebuffer, in physical pixels
+	const struct wlc_size *resolution = wlc_output_get_resolution(output->handle);
+	g->size.w = clamp_range(json_object_get_int(x), json_object_get_int(w),
+			resolution->w, &g->origin.x);
+	g->size.h = clamp_range(json_object_get_int(y), json_object_get_int(h),
+			resolution->h, &g->origin.y);
+	if (!g->size.w || !g->size.h) {
+		g->size.w = g->size.h = 0;
+	}
+	return output;
+}
+
+static void ipc_capture_free(struct ipc_capture *capture) {
+	if (!capture) {
+		return;
+	}
+	if (capture->map) {
+		munmap(capture->map, capture->buffer_size * capture->buffers);
+	}
+	free(capture);
+}
+
+static void ipc_capture_reply(struct ipc_client *client, bool success,
+		const char *error, struct ipc_capture *capture, int fd) {
+	json_object *reply = json_object_new_object();
+	json_object_object_add(reply, "success", json_object_new_boolean(success));
+	if (error) {
+		json_object_object_add(reply, "error", json_object_new_string(error));
+	}
+	if (capture) {
+		json_object_object_add(reply, "buffers", json_object_new_int(capture->buffers));
+		json_object_object_add(reply, "buffer_size",
+				json_object_new_int64((int64_t)capture->buffer_size));
+	}
+	const char *json_string = json_object_to_json_string(reply);
+	struct ipc_message *message = ipc_message_create(client->current_command,
+			json_string, strlen(json_string));
+	json_object_put(reply);
+	if (message) {
+		message->fd = fd;
+	} else if (fd != -1) {
+		close(fd);
+	}
+	ipc_send_message(client, message);
+}
+
+/**
+ * Starts, stops or releases a buffer of the capture of client, see
+ * ipc-capture.h.
+ */
+static void ipc_capture_request(struct ipc_client *client, const char *buf) {
+	json_object *request = json_tokener_parse(buf), *value;
+	if (!request) {
+		ipc_capture_reply(client, false, "Unable to parse request", NULL, -1);
+		return;
+	}
+	if (json_object_object_get_ex(request, "release", &value)) {
+		int buffer = json_object_get_int(value);
+		if (client->capture && buffer >= 0 && (uint32_t)buffer < client->capture->buffers) {
+			client->capture->busy &= ~(1u << buffer);
+			ipc_capture_reply(client, true, NULL, NULL, -1);
+		} else {
+			ipc_capture_reply(client, false, "No such buffer", NULL, -1);
+		}
+		json_object_put(request);
+		return;
+	}
+	if (json_object_object_get_ex(request, "stop", &value)) {
+		ipc_capture_free(client->capture);
+		client->capture = NULL;
+		ipc_capture_reply(client, true, NULL, NULL, -1);
+		json_object_put(request);
+		return;
+	}
+
+	struct wlc_geometry g;
+	swayc_t *output = ipc_parse_pixels_request(request, &g);
+	int buffers = json_object_object_get_ex(request, "buffers", &value) ?
+		json_object_get_int(value) : 3;
+	json_object_put(request);
+	if (!output || g.size.w == 0 || g.size.h == 0) {
+		ipc_capture_reply(client, false, "Unknown output or empty area", NULL, -1);
+		return;
+	}
+	// all buffers together stay within what a client may have queued
+	size_t buffer_size = (size_t)g.size.w * g.size.h * 4;
+	size_t max_buffers = ipc_client_queue_limit / buffer_size;
+	if (max_buffers == 0) {
+		ipc_capture_reply(client, false, "Area too large", NULL, -1);
+		return;
+	}
+	if (max_buffers > ipc_capture_max_buffers) {
+		max_buffers = ipc_capture_max_buffers;
+	}
+
+	ipc_capture_free(client->capture);
+	client->capture = NULL;
+	struct ipc_capture *capture = calloc(1, sizeof(struct ipc_capture));
+	if (!capture) {
+		sway_log(L_ERROR, "Unable to allocate capture");
+		ipc_client_disconnect(client);
+		return;
+	}
+	capture->output = output->handle;
+	capture->geo = g;
+	capture->buffers = buffers < 1 ? 1 : (size_t)buffers > max_buffers ?
+		(uint32_t)max_buffers : (uint32_t)buffers;
+	capture->buffer_size = buffer_size;
+	size_t size = capture->buffer_size * capture->buffers;
+	int read_fd;
+	int fd = create_shm_file("sway-capture", size, &read_fd);
+	if (fd == -1) {
+		sway_log_errno(L_ERROR, "Unable to create capture buffers");
+		ipc_capture_free(capture);
+		ipc_capture_reply(client, false, "Unable to create buffers", NULL, -1);
+		return;
+	}
+	capture->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (capture->map == MAP_FAILED) {
+		sway_log_errno(L_ERROR, "Unable to map capture buffers");
+		capture->map = NULL;
+		ipc_capture_free(capture);
+		close(read_fd);
+		ipc_capture_reply(client, false, "Unable to create buffers", NULL, -1);
+		return;
+	}
+	client->capture = capture;
+	ipc_capture_reply(client, true, NULL, capture, read_fd);
+	// the first frame shows what is on the output right now
+	wlc_output_schedule_render(capture->output);
+}
+
+void ipc_capture_frames(wlc_handle output) {
+	struct timespec now;
+	bool have_time = false;
+	for (int i = 0; i < ipc_client_list->length; ++i) {
+		struct ipc_client *client = ipc_client_list->items[i];
+		struct ipc_capture *capture = client->capture;
+		if (!capture || capture->output != output) {
+			continue;
+		}
+		uint32_t buffer = 0;
+		while (buffer < capture->buffers && (capture->busy & (1u << buffer))) {
+			++buffer;
+		}
+		if (buffer == capture->buffers) {
+			capture->skipped++;
+			continue;
+		}
+		if (!have_time) {
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			have_time = true;
+		}
+
+		struct wlc_geometry g_out;
+		wlc_pixels_read(WLC_RGBA8888, &capture->geo, &g_out,
+				capture->map + buffer * capture->buffer_size);
+		capture->busy |= 1u << buffer;
+		struct ipc_capture_frame frame = {
+			.sequence = capture->sequence++,
+			.buffer = buffer,
+			.width = g_out.size.w,
+			.height = g_out.size.h,
+			.skipped = capture->skipped,
+			.time = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec,
+		};
+		capture->skipped = 0;
+		struct ipc_message *message = ipc_message_create(IPC_EVENT_CAPTURE,
+				(const char *)&frame, sizeof(frame));
+		if (!ipc_send_message(client, message)) {
+			// the client was removed from the list
+			i--;
+		}
+	}
+}
+
+/**
+ * Makes sure the shared pixel buffer of client holds at least size bytes.
+ * Returns a read-only descriptor for the client if a new buffer had to be
+ * created, -1 if the current one is big enough or on errors (leaving
+ * client->pixels_map NULL).
+ */
+static int ipc_client_pixels_reserve(struct ipc_client *client, size_t size) {
+	if (client->pixels_map && client->pixels_size >= size) {
+		return -1;
+	}
+	if (client->pixels_map) {
+		munmap(client->pixels_map, client->pixels_size);
+		client->pixels_map = NULL;
+		client->pixels_size = 0;
+	}
+	int read_fd;
+	int fd = create_shm_file("sway-pixels", size, &read_fd);
+	if (fd == -1) {
+		sway_log_errno(L_ERROR, "Unable to create pixel buffer");
+		return -1;
+	}
+	char *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		sway_log_errno(L_ERROR, "Unable to map pixel buffer");
+		close(read_fd);
+		return -1;
+	}
+	client->pixels_map = map;
+	client->pixels_size = size;
+	return read_fd;
+}
+
+/**
+ * Reads the pixels straight into the shared buffer of the client. The reply
+ * only holds the header, with 2 instead of 1 in the first byte, and the
+ * buffer's descriptor whenever it was replaced.
+ */
+static void ipc_get_pixels_shm(struct get_pixels_request *req) {
+	struct ipc_client *client = req->client;
+	char response_header[9];
+	memset(response_header, 0, sizeof(response_header));
+
+	size_t size = (size_t)req->geo.size.w * req->geo.size.h * 4;
+	if (size > ipc_client_queue_limit) {
+		sway_log(L_ERROR, "Refusing get_pixels of %zu bytes", size);
+		size = 0;
+	}
+	int fd = size ? ipc_client_pixels_reserve(client, size) : -1;
+	if (size && client->pixels_map) {
+		struct wlc_geometry g_out;
+		wlc_pixels_read(WLC_RGBA8888, &req->geo, &g_out, client->pixels_map);
+		response_header[0] = 2;
+		uint32_t dimensions[2] = { g_out.size.w, g_out.size.h };
+		memcpy(response_header + 1, dimensions, sizeof(dimensions));
+	}
+
+	struct ipc_message *message = ipc_message_create(IPC_SWAY_GET_PIXELS,
+			response_header, sizeof(response_header));
+	if (message) {
+		message->fd = fd;
+	} else if (fd != -1) {
+		close(fd);
+	}
+	ipc_send_message(client, message);
+}
+
 void ipc_get_pixels(wlc_handle output) {
 	if (ipc_get_pixel_requests->length == 0) {
 		return;
 	}
 
-	list_t *unhandled = create_list();
+	// requests for other outputs go back to the list, replies may disconnect
+	// clients which drops their requests from it
+	list_t *requests = ipc_get_pixel_requests;
+	ipc_get_pixel_requests = create_list();
 
 	struct get_pixels_request *req;
 	int i;
-	for (i = 0; i < ipc_get_pixel_requests->length; ++i) {
-		req = ipc_get_pixel_requests->items[i];
+	for (i = 0; i < requests->length; ++i) {
+		req = requests->items[i];
+		if (!ipc_client_alive(req->client)) {
+			free(req);
+			continue;
+		}
 		if (req->output != output) {
-			list_add(unhandled, req);
+			list_add(ipc_get_pixel_requests, req);
+			continue;
+		}
+
+		if (req->shm) {
+			ipc_get_pixels_shm(req);
+			free(req);
 			continue;
 		}
 
@@ -406,10 +1181,7 @@ void ipc_get_pixels(wlc_handle output) {
 		free(req);
 	}
 
-	// free old list of pixel requests and set new list to all unhandled
-	// requests (request for another output).
-	list_free(ipc_get_pixel_requests);
-	ipc_get_pixel_requests = unhandled;
+	list_free(requests);
 }
 
 static bool is_text_target(const char *target) {
@@ -672,30 +1444,11 @@ cleanup:
 	free(types);
 }
 
-void ipc_client_handle_command(struct ipc_client *client) {
+void ipc_client_handle_command(struct ipc_client *client, char *buf) {
 	if (!sway_assert(client != NULL, "client != NULL")) {
 		return;
 	}
 
-	char *buf = malloc(client->payload_length + 1);
-	if (!buf) {
-		sway_log_errno(L_INFO, "Unable to allocate IPC payload");
-		ipc_client_disconnect(client);
-		return;
-	}
-	if (client->payload_length > 0) {
-		// Payload should be fully available
-		ssize_t received = recv(client->fd, buf, client->payload_length, 0);
-		if (received == -1)
-		{
-			sway_log_errno(L_INFO, "Unable to receive payload from IPC client");
-			ipc_client_disconnect(client);
-			free(buf);
-			return;
-		}
-	}
-	buf[client->payload_length] = '\0';
-
 	const char *error_denied = "{ \"success\": false, \"error\": \"Permission denied\" }";
 
 	switch (client->current_command) {
@@ -723,9 +1476,29 @@ void ipc_client_handle_command(struct ipc_client *client) {
 			goto exit_cleanup;
 		}
 
+		// either a list of event types, or an object listing them in
+		// events along with options
+		struct json_object *events = request, *coalesce;
+		if (json_object_is_type(request, json_type_object)) {
+			if (!json_object_object_get_ex(request, "events", &events)
+					|| !json_object_is_type(events, json_type_array)) {
+				ipc_send_reply(client, "{\"success\": false}", 18);
+				json_object_put(request);
+				sway_log(L_INFO, "Subscription without events");
+				goto exit_cleanup;
+			}
+			if (json_object_object_get_ex(request, "coalesce", &coalesce)) {
+				int interval = json_object_get_int(coalesce);
+				if (!ipc_client_set_coalesce_interval(client, interval < 0 ? 0 : interval)) {
+					json_object_put(request);
+					goto exit_cleanup;
+				}
+			}
+		}
+
 		// parse requested event types
-		for (int i = 0; i < json_object_array_length(request); i++) {
-			const char *event_type = json_object_get_string(json_object_array_get_idx(request, i));
+		for (int i = 0; i < json_object_array_length(events); i++) {
+			const char *event_type = json_object_get_string(json_object_array_get_idx(events, i));
 			if (strcmp(event_type, "workspace") == 0) {
 				client->subscribed_events |= event_mask(IPC_EVENT_WORKSPACE);
 			} else if (strcmp(event_type, "barconfig_update") == 0) {
@@ -738,6 +1511,19 @@ void ipc_client_handle_command(struct ipc_client *client) {
 				client->subscribed_events |= event_mask(IPC_EVENT_MODIFIER);
 			} else if (strcmp(event_type, "binding") == 0) {
 				client->subscribed_events |= event_mask(IPC_EVENT_BINDING);
+			} else if (strcmp(event_type, "tree") == 0) {
+				// patches queued for others describe changes this client
+				// will learn about from its next get_tree
+				ipc_event_tree_flush();
+				if (!ipc_client_alive(client)) {
+					// flushing overflowed the queue of this very client
+					json_object_put(request);
+					goto exit_cleanup;
+				}
+				client->subscribed_events |= event_mask(IPC_EVENT_TREE);
+				if (!ipc_tree_diff && !(ipc_tree_diff = tree_diff_create())) {
+					sway_log(L_ERROR, "Unable to track tree changes");
+				}
 			} else {
 				ipc_send_reply(client, "{\"success\": false}", 18);
 				json_object_put(request);
@@ -757,11 +1543,15 @@ void ipc_client_handle_command(struct ipc_client *client) {
 		if (!(client->security_policy & IPC_FEATURE_GET_WORKSPACES)) {
 			goto exit_denied;
 		}
-		json_object *workspaces = json_object_new_array();
-		container_map(&root_container, ipc_get_workspaces_callback, workspaces);
-		const char *json_string = json_object_to_json_string(workspaces);
-		ipc_send_reply(client, json_string, (uint32_t) strlen(json_string));
-		json_object_put(workspaces); // free
+		// report the geometry the next frame will have
+		flush_arrange_windows();
+		if (ipc_send_cached_reply(client)) {
+			goto exit_cleanup;
+		}
+		struct ipc_json_buffer reply;
+		ipc_json_buffer_init(&reply, ipc_header_size);
+		ipc_json_write_workspaces(&reply);
+		ipc_send_cacheable_reply(client, ipc_message_from_json_buffer(client->current_command, &reply));
 		goto exit_cleanup;
 	}
 
@@ -788,10 +1578,15 @@ void ipc_client_handle_command(struct ipc_client *client) {
 		if (!(client->security_policy & IPC_FEATURE_GET_OUTPUTS)) {
 			goto exit_denied;
 		}
+		flush_arrange_windows();
+		if (ipc_send_cached_reply(client)) {
+			goto exit_cleanup;
+		}
 		json_object *outputs = json_object_new_array();
 		container_map(&root_container, ipc_get_outputs_callback, outputs);
 		const char *json_string = json_object_to_json_string(outputs);
-		ipc_send_reply(client, json_string, (uint32_t) strlen(json_string));
+		ipc_send_cacheable_reply(client, ipc_message_create(client->current_command,
+				json_string, strlen(json_string)));
 		json_object_put(outputs); // free
 		goto exit_cleanup;
 	}
@@ -801,10 +1596,19 @@ void ipc_client_handle_command(struct ipc_client *client) {
 		if (!(client->security_policy & IPC_FEATURE_GET_TREE)) {
 			goto exit_denied;
 		}
-		json_object *tree = ipc_json_describe_container_recursive(&root_container);
-		const char *json_string = json_object_to_json_string(tree);
-		ipc_send_reply(client, json_string, (uint32_t) strlen(json_string));
-		json_object_put(tree);
+		flush_arrange_windows();
+		// tree subscribers get every patch up to this reply before it
+		ipc_event_tree_flush();
+		if (!ipc_client_alive(client)) {
+			goto exit_cleanup;
+		}
+		if (ipc_send_cached_reply(client)) {
+			goto exit_cleanup;
+		}
+		struct ipc_json_buffer reply;
+		ipc_json_buffer_init(&reply, ipc_header_size);
+		ipc_json_write_tree(&reply, &root_container);
+		ipc_send_cacheable_reply(client, ipc_message_from_json_buffer(client->current_command, &reply));
 		goto exit_cleanup;
 	}
 
@@ -813,14 +1617,87 @@ void ipc_client_handle_command(struct ipc_client *client) {
 		if (!(client->security_policy & IPC_FEATURE_GET_MARKS)) {
 			goto exit_denied;
 		}
+		if (ipc_send_cached_reply(client)) {
+			goto exit_cleanup;
+		}
+		// the index has no order, report the marks in tree order as a walk
+		// of the tree would
+		list_t *containers = create_list();
+		mark_index_foreach(ipc_get_marks_callback, containers);
+		container_sort_tree_order(containers);
 		json_object *marks = json_object_new_array();
-		container_map(&root_container, ipc_get_marks_callback, marks);
+		for (int i = 0; i < containers->length; ++i) {
+			swayc_t *container = containers->items[i];
+			for (int j = 0; j < container->marks->length; ++j) {
+				json_object_array_add(marks, json_object_new_string(container->marks->items[j]));
+			}
+		}
+		list_free(containers);
 		const char *json_string = json_object_to_json_string(marks);
-		ipc_send_reply(client, json_string, (uint32_t) strlen(json_string));
+		ipc_send_cacheable_reply(client, ipc_message_create(client->current_command,
+				json_string, strlen(json_string)));
 		json_object_put(marks);
 		goto exit_cleanup;
 	}
 
+	case IPC_SWAY_GET_TREE_GENERATION:
+	{
+		if (!(client->security_policy & (IPC_FEATURE_GET_WORKSPACES | IPC_FEATURE_GET_OUTPUTS
+						| IPC_FEATURE_GET_TREE | IPC_FEATURE_GET_MARKS))) {
+			goto exit_denied;
+		}
+		// pending layout changes are changes as well
+		flush_arrange_windows();
+		ipc_event_tree_flush();
+		if (!ipc_client_alive(client)) {
+			goto exit_cleanup;
+		}
+		char reply[64];
+		int length = snprintf(reply, sizeof(reply), "{ \"generation\": %" PRIu64 " }",
+				get_tree_generation());
+		ipc_send_reply(client, reply, (uint32_t)length);
+		goto exit_cleanup;
+	}
+
+	case IPC_SWAY_GET_TREE_SNAPSHOT:
+	{
+		if (!(client->security_policy & IPC_FEATURE_GET_TREE)) {
+			goto exit_denied;
+		}
+		flush_arrange_windows();
+		if (ipc_tree_snapshot) {
+			tree_snapshot_update(ipc_tree_snapshot);
+		} else {
+			ipc_tree_snapshot = tree_snapshot_create();
+		}
+		int fd = ipc_tree_snapshot ? tree_snapshot_get_fd(ipc_tree_snapshot) : -1;
+		if (fd == -1) {
+			const char *error = "{ \"success\": false, \"error\": \"Unable to share the tree\" }";
+			ipc_send_reply(client, error, (uint32_t)strlen(error));
+			goto exit_cleanup;
+		}
+		const char *success = "{ \"success\": true }";
+		struct ipc_message *message = ipc_message_create(client->current_command,
+				success, strlen(success));
+		if (message) {
+			message->fd = fd;
+		} else {
+			close(fd);
+		}
+		ipc_send_message(client, message);
+		goto exit_cleanup;
+	}
+
+	case IPC_SWAY_GET_CONTAINERS:
+	{
+		if (!(client->security_policy & IPC_FEATURE_GET_TREE)) {
+			goto exit_denied;
+		}
+		flush_arrange_windows();
+		ipc_get_containers(client, buf);
+		goto exit_cleanup;
+	}
+
 	case IPC_GET_VERSION:
 	{
 		json_object *version = ipc_json_get_version();
@@ -836,26 +1713,11 @@ void ipc_client_handle_command(struct ipc_client *client) {
 		memset(response_header, 0, sizeof(response_header));
 
 		json_object *obj = json_tokener_parse(buf);
-		json_object *o, *x, *y, *w, *h;
-
-		json_object_object_get_ex(obj, "output", &o);
-		json_object_object_get_ex(obj, "x", &x);
-		json_object_object_get_ex(obj, "y", &y);
-		json_object_object_get_ex(obj, "w", &w);
-		json_object_object_get_ex(obj, "h", &h);
-
-		struct wlc_geometry g = {
-			.origin = {
-				.x = json_object_get_int(x),
-				.y = json_object_get_int(y)
-			},
-			.size = {
-				.w = json_object_get_int(w),
-				.h = json_object_get_int(h)
-			}
-		};
-
-		swayc_t *output = swayc_by_test(&root_container, output_by_name_test, (void *)json_object_get_string(o));
+		json_object *shm;
+		bool use_shm = json_object_object_get_ex(obj, "shm", &shm)
+			&& json_object_get_boolean(shm);
+		struct wlc_geometry g;
+		swayc_t *output = ipc_parse_pixels_request(obj, &g);
 		json_object_put(obj);
 
 		if (!output) {
@@ -871,11 +1733,21 @@ void ipc_client_handle_command(struct ipc_client *client) {
 		req->client = client;
 		req->output = output->handle;
 		req->geo = g;
+		req->shm = use_shm;
 		list_add(ipc_get_pixel_requests, req);
 		wlc_output_schedule_render(output->handle);
 		goto exit_cleanup;
 	}
 
+	case IPC_SWAY_CAPTURE:
+	{
+		if (!(client->security_policy & IPC_FEATURE_CAPTURE)) {
+			goto exit_denied;
+		}
+		ipc_capture_request(client, buf);
+		goto exit_cleanup;
+	}
+
 	case IPC_GET_BAR_CONFIG:
 	{
 		if (!(client->security_policy & IPC_FEATURE_GET_BAR_CONFIG)) {
@@ -936,84 +1808,321 @@ exit_denied:
 	sway_log(L_DEBUG, "Denied IPC client access to %i", client->current_command);
 
 exit_cleanup:
-	client->payload_length = 0;
-	free(buf);
 	return;
 }
 
 bool ipc_send_reply(struct ipc_client *client, const char *payload, uint32_t payload_length) {
 	assert(payload);
 
-	char data[ipc_header_size];
-	uint32_t *data32 = (uint32_t*)(data + sizeof(ipc_magic));
+	struct ipc_message *message = ipc_message_create(client->current_command, payload, payload_length);
+	if (!ipc_send_message(client, message)) {
+		return false;
+	}
 
-	memcpy(data, ipc_magic, sizeof(ipc_magic));
-	data32[0] = payload_length;
-	data32[1] = client->current_command;
+	sway_log(L_DEBUG, "Added IPC reply to client %d queue: %s", client->fd, payload);
 
-	while (client->write_buffer_len + ipc_header_size + payload_length >=
-				 client->write_buffer_size) {
-		client->write_buffer_size *= 2;
-	}
+	return true;
+}
+
+/**
+ * Turns the buffer of a streamed reply into a message, or returns NULL (and
+ * frees the buffer) if serializing failed.
+ */
+static struct ipc_message *ipc_message_from_json_buffer(enum ipc_command_type type,
+		struct ipc_json_buffer *buf) {
+	if (buf->error) {
+		sway_log(L_ERROR, "Unable to serialize ipc reply");
+		free(buf->data);
+		return NULL;
+	}
+	return ipc_message_adopt(type, buf->data, buf->length);
+}
 
-	// TODO: reduce the limit back to 4 MB when screenshooter is implemented
-	if (client->write_buffer_size > (1 << 28)) { // 256 MB
-		sway_log(L_ERROR, "Client write buffer too big, disconnecting client");
+/**
+ * Queues message on client, consuming the reference of the caller. message
+ * may be NULL if creating it failed.
+ */
+static bool ipc_send_message(struct ipc_client *client, struct ipc_message *message) {
+	if (!message) {
+		sway_log(L_ERROR, "Unable to allocate ipc reply");
 		ipc_client_disconnect(client);
 		return false;
 	}
-
-	char *new_buffer = realloc(client->write_buffer, client->write_buffer_size);
-	if (!new_buffer) {
-		sway_log(L_ERROR, "Unable to reallocate ipc client write buffer");
+	bool queued = ipc_client_queue(client, message);
+	ipc_message_unref(message);
+	if (!queued) {
 		ipc_client_disconnect(client);
 		return false;
 	}
-	client->write_buffer = new_buffer;
+	return true;
+}
 
-	memcpy(client->write_buffer + client->write_buffer_len, data, ipc_header_size);
-	client->write_buffer_len += ipc_header_size;
-	memcpy(client->write_buffer + client->write_buffer_len, payload, payload_length);
-	client->write_buffer_len += payload_length;
+/**
+ * Sends a reply to a read-only query and keeps it for the following queries
+ * at the current tree generation.
+ */
+static bool ipc_send_cacheable_reply(struct ipc_client *client, struct ipc_message *message) {
+	if (message) {
+		ipc_reply_cache_set(client->current_command, message, get_tree_generation());
+		sway_log(L_DEBUG, "Added IPC reply to client %d queue (%zu bytes)",
+				client->fd, message->size);
+	}
+	return ipc_send_message(client, message);
+}
 
-	if (!client->writable_event_source) {
-		client->writable_event_source = wlc_event_loop_add_fd(client->fd, WLC_EVENT_WRITABLE, ipc_client_handle_writable, client);
+static bool ipc_send_cached_reply(struct ipc_client *client) {
+	struct ipc_message *message = ipc_reply_cache_get(client->current_command);
+	if (!message) {
+		return false;
 	}
+	sway_log(L_DEBUG, "Added cached IPC reply to client %d queue (%zu bytes)",
+			client->fd, message->size);
+	message->refcount++;
+	ipc_send_message(client, message);
+	return true;
+}
 
-	sway_log(L_DEBUG, "Added IPC reply to client %d queue: %s", client->fd, payload);
+void ipc_get_outputs_callback(swayc_t *container, void *data) {
+	if (container->type == C_OUTPUT) {
+		json_object_array_add((json_object *)data, ipc_json_describe_container(container));
+	}
+}
+
+static void ipc_get_marks_callback(const char *mark, swayc_t *container, void *data) {
+	// once per container, hidden scratchpad views are not in the tree
+	if (mark == container->marks->items[0] && swayc_in_tree(container)) {
+		list_add((list_t *)data, container);
+	}
+}
+
+static void ipc_get_containers_callback(swayc_t *container, void *data) {
+	list_add((list_t *)data, container);
+}
+
+static void ipc_get_containers_error(struct ipc_client *client, const char *error) {
+	json_object *reply = json_object_new_object();
+	json_object_object_add(reply, "success", json_object_new_boolean(false));
+	json_object_object_add(reply, "error", json_object_new_string(error));
+	const char *json_string = json_object_to_json_string(reply);
+	ipc_send_reply(client, json_string, (uint32_t)strlen(json_string));
+	json_object_put(reply);
+}
 
+static bool ipc_is_string_array(json_object *array) {
+	if (!json_object_is_type(array, json_type_array)) {
+		return false;
+	}
+	for (int i = 0; i < json_object_array_length(array); ++i) {
+		if (!json_object_is_type(json_object_array_get_idx(array, i), json_type_string)) {
+			return false;
+		}
+	}
 	return true;
 }
 
-void ipc_get_workspaces_callback(swayc_t *workspace, void *data) {
-	if (workspace->type == C_WORKSPACE) {
-		json_object *workspace_json = ipc_json_describe_container(workspace);
-		// override the default focused indicator because
-		// it's set differently for the get_workspaces reply
-		bool focused = root_container.focused == workspace->parent && workspace->parent->focused == workspace;
-		json_object_object_del(workspace_json, "focused");
-		json_object_object_add(workspace_json, "focused", json_object_new_boolean(focused));
-		json_object_array_add((json_object *)data, workspace_json);
+/**
+ * Replies with the views matching request.criteria, or every container if
+ * there is none, limited to those of request.type (root, output, workspace,
+ * container or view) and each described with only the keys in request.fields.
+ */
+static void ipc_get_containers(struct ipc_client *client, const char *buf) {
+	json_object *request = NULL, *criteria = NULL, *type = NULL, *fields = NULL;
+	if (*buf && !(request = json_tokener_parse(buf))) {
+		ipc_get_containers_error(client, "Unable to parse request");
+		return;
+	}
+	if (request && (!json_object_is_type(request, json_type_object)
+			|| (json_object_object_get_ex(request, "criteria", &criteria)
+				&& !json_object_is_type(criteria, json_type_string))
+			|| (json_object_object_get_ex(request, "type", &type)
+				&& !json_object_is_type(type, json_type_string))
+			|| (json_object_object_get_ex(request, "fields", &fields)
+				&& !ipc_is_string_array(fields)))) {
+		ipc_get_containers_error(client,
+				"Expected { \"criteria\": string, \"type\": string, \"fields\": [ string ] }");
+		json_object_put(request);
+		return;
 	}
+
+	list_t *containers;
+	const char *criteria_string = criteria ? json_object_get_string(criteria) : "";
+	if (*criteria_string) {
+		list_t *tokens = create_list();
+		char *error = extract_crit_tokens(tokens, criteria_string);
+		if (error) {
+			ipc_get_containers_error(client, error);
+			free(error);
+			free_crit_tokens(tokens);
+			json_object_put(request);
+			return;
+		}
+		containers = container_for(tokens);
+		free_crit_tokens(tokens);
+	} else {
+		containers = create_list();
+		container_map(&root_container, ipc_get_containers_callback, containers);
+		// hidden scratchpad views are out of the tree, container_for lists
+		// them as well
+		for (int i = 0; i < scratchpad->length; ++i) {
+			swayc_t *top = scratchpad->items[i];
+			while (top->parent) {
+				top = top->parent;
+			}
+			if (top != &root_container) {
+				list_add(containers, scratchpad->items[i]);
+			}
+		}
+	}
+
+	const char *type_string = type ? json_object_get_string(type) : NULL;
+	if (type_string) {
+		for (int i = 0; i < containers->length; ++i) {
+			swayc_t *container = containers->items[i];
+			if (strcasecmp(type_string, swayc_type_string(container->type)) != 0) {
+				list_del(containers, i--);
+			}
+		}
+	}
+
+	int count = fields ? json_object_array_length(fields) : 0;
+	const char **names = NULL;
+	if (fields && !(names = calloc(count ? count : 1, sizeof(char *)))) {
+		sway_log(L_ERROR, "Unable to allocate container query");
+		list_free(containers);
+		json_object_put(request);
+		ipc_client_disconnect(client);
+		return;
+	}
+	for (int i = 0; i < count; ++i) {
+		names[i] = json_object_get_string(json_object_array_get_idx(fields, i));
+	}
+
+	struct ipc_json_buffer reply;
+	ipc_json_buffer_init(&reply, ipc_header_size);
+	ipc_json_write_containers(&reply, containers, names, count);
+	ipc_send_message(client, ipc_message_from_json_buffer(client->current_command, &reply));
+	free(names);
+	list_free(containers);
+	json_object_put(request);
 }
 
-void ipc_get_outputs_callback(swayc_t *container, void *data) {
-	if (container->type == C_OUTPUT) {
-		json_object_array_add((json_object *)data, ipc_json_describe_container(container));
+/**
+ * Returns a copy of the event message with a "coalesced" member counting the
+ * events it stands for.
+ */
+static struct ipc_message *ipc_message_with_merged_count(struct ipc_message *message,
+		uint32_t merged) {
+	// json-c ends objects with " }"
+	const char *payload = message->data + ipc_header_size;
+	size_t length = message->size - ipc_header_size;
+	if (length < 2 || strncmp(payload + length - 2, " }", 2) != 0) {
+		message->refcount++;
+		return message;
+	}
+	char member[64];
+	int member_length = snprintf(member, sizeof(member), ", \"coalesced\": %" PRIu32 " }", merged);
+	uint32_t header[2];
+	memcpy(header, message->data + sizeof(ipc_magic), sizeof(header));
+	size_t size = ipc_header_size + length - 2 + member_length;
+	char *buffer = malloc(size);
+	if (!buffer) {
+		return NULL;
+	}
+	memcpy(buffer + ipc_header_size, payload, length - 2);
+	memcpy(buffer + ipc_header_size + length - 2, member, member_length);
+	return ipc_message_adopt(header[1], buffer, size);
+}
+
+/**
+ * Sends the events client held back, in the order they first came up. Returns
+ * false if the client was disconnected.
+ */
+static bool ipc_client_flush_coalesced(struct ipc_client *client) {
+	if (!client->coalesced || client->coalesced->length == 0) {
+		return true;
+	}
+	bool alive = true;
+	for (int i = 0; i < client->coalesced->length; ++i) {
+		struct ipc_coalesced_event *pending = client->coalesced->items[i];
+		struct ipc_message *message = pending->message;
+		if (alive && pending->merged > 0) {
+			// the latest event counts itself too
+			message = ipc_message_with_merged_count(message, pending->merged + 1);
+			ipc_message_unref(pending->message);
+		}
+		if (alive && !(alive = message && ipc_client_queue(client, message))) {
+			sway_log(L_INFO, "Unable to send event to IPC client");
+		}
+		if (message) {
+			ipc_message_unref(message);
+		}
+		free(pending);
 	}
+	client->coalesced->length = 0;
+	if (!alive) {
+		ipc_client_disconnect(client);
+	}
+	return alive;
+}
+
+static int ipc_client_handle_coalesced(void *data) {
+	ipc_client_flush_coalesced(data);
+	return 0;
 }
 
-static void ipc_get_marks_callback(swayc_t *container, void *data) {
-	json_object *object = (json_object *)data;
-	if (container->marks) {
-		for (int i = 0; i < container->marks->length; ++i) {
-			char *mark = (char *)container->marks->items[i];
-			json_object_array_add(object, json_object_new_string(mark));
+/**
+ * Holds message back until the coalesce interval of client passed, replacing
+ * an older event with the same key.
+ */
+static bool ipc_client_coalesce(struct ipc_client *client,
+		struct ipc_message *message, const struct ipc_event_key *key) {
+	for (int i = 0; i < client->coalesced->length; ++i) {
+		struct ipc_coalesced_event *pending = client->coalesced->items[i];
+		if (pending->key.event == key->event && pending->key.id == key->id
+				&& strcmp(pending->key.change, key->change) == 0) {
+			ipc_message_unref(pending->message);
+			pending->message = message;
+			pending->merged++;
+			message->refcount++;
+			return true;
 		}
 	}
+	struct ipc_coalesced_event *pending = malloc(sizeof(struct ipc_coalesced_event));
+	if (!pending) {
+		return false;
+	}
+	pending->key = *key;
+	pending->message = message;
+	pending->merged = 0;
+	message->refcount++;
+	list_add(client->coalesced, pending);
+	if (client->coalesced->length == 1) {
+		wlc_event_source_timer_update(client->coalesce_event_source, client->coalesce_interval);
+	}
+	return true;
 }
 
-void ipc_send_event(const char *json_string, enum ipc_command_type event) {
+static bool ipc_client_set_coalesce_interval(struct ipc_client *client, uint32_t interval) {
+	if (!ipc_client_flush_coalesced(client)) {
+		return false;
+	}
+	if (interval && !client->coalesced && !(client->coalesced = create_list())) {
+		sway_log(L_ERROR, "Unable to allocate ipc client event list");
+		ipc_client_disconnect(client);
+		return false;
+	}
+	if (interval && !client->coalesce_event_source && !(client->coalesce_event_source =
+				wlc_event_loop_add_timer(ipc_client_handle_coalesced, client))) {
+		sway_log(L_ERROR, "Unable to create ipc client event timer");
+		ipc_client_disconnect(client);
+		return false;
+	}
+	client->coalesce_interval = interval;
+	return true;
+}
+
+static void ipc_send_event_keyed(const char *json_string, enum ipc_command_type event,
+		const struct ipc_event_key *key) {
 	static struct {
 		enum ipc_command_type event;
 		enum ipc_feature feature;
@@ -1023,7 +2132,8 @@ void ipc_send_event(const char *json_string, enum ipc_command_type event) {
 		{ IPC_EVENT_MODE, IPC_FEATURE_EVENT_MODE },
 		{ IPC_EVENT_WINDOW, IPC_FEATURE_EVENT_WINDOW },
 		{ IPC_EVENT_BINDING, IPC_FEATURE_EVENT_BINDING },
-		{ IPC_EVENT_INPUT, IPC_FEATURE_EVENT_INPUT }
+		{ IPC_EVENT_INPUT, IPC_FEATURE_EVENT_INPUT },
+		{ IPC_EVENT_TREE, IPC_FEATURE_EVENT_TREE }
 	};
 
 	uint32_t security_mask = 0;
@@ -1034,6 +2144,8 @@ void ipc_send_event(const char *json_string, enum ipc_command_type event) {
 		}
 	}
 
+	// serialized on the first subscriber and shared by all of them
+	struct ipc_message *message = NULL;
 	int i;
 	struct ipc_client *client;
 	for (i = 0; i < ipc_client_list->length; i++) {
@@ -1044,12 +2156,34 @@ void ipc_send_event(const char *json_string, enum ipc_command_type event) {
 		if ((client->subscribed_events & event_mask(event)) == 0) {
 			continue;
 		}
-		client->current_command = event;
-		if (!ipc_send_reply(client, json_string, (uint32_t) strlen(json_string))) {
-			sway_log_errno(L_INFO, "Unable to send reply to IPC client");
+		if (!message && !(message = ipc_message_create(event, json_string, strlen(json_string)))) {
+			sway_log(L_ERROR, "Unable to allocate ipc event");
+			return;
+		}
+		bool sent;
+		if (key && client->coalesce_interval) {
+			sent = ipc_client_coalesce(client, message, key);
+		} else if (!ipc_client_flush_coalesced(client)) {
+			// held back events go first, sending them failed
+			i--;
+			continue;
+		} else {
+			sent = ipc_client_queue(client, message);
+		}
+		if (!sent) {
+			sway_log(L_INFO, "Unable to send event to IPC client");
 			ipc_client_disconnect(client);
+			// the client was removed from the list
+			i--;
 		}
 	}
+	if (message) {
+		ipc_message_unref(message);
+	}
+}
+
+void ipc_send_event(const char *json_string, enum ipc_command_type event) {
+	ipc_send_event_keyed(json_string, event, NULL);
 }
 
 void ipc_event_workspace(swayc_t *old, swayc_t *new, const char *change) {
@@ -1083,11 +2217,80 @@ void ipc_event_window(swayc_t *window, const char *change) {
 	json_object_object_add(obj, "container", ipc_json_describe_container_recursive(window));
 
 	const char *json_string = json_object_to_json_string(obj);
-	ipc_send_event(json_string, IPC_EVENT_WINDOW);
+	if (strcmp(change, "title") == 0) {
+		// titles with spinners change many times a second
+		struct ipc_event_key key = { IPC_EVENT_WINDOW, window->id, "title" };
+		ipc_send_event_keyed(json_string, IPC_EVENT_WINDOW, &key);
+	} else {
+		ipc_send_event(json_string, IPC_EVENT_WINDOW);
+	}
+
+	json_object_put(obj); // free
+}
+
+static bool ipc_event_tree_subscribed(void) {
+	for (int i = 0; i < ipc_client_list->length; ++i) {
+		struct ipc_client *client = ipc_client_list->items[i];
+		if ((client->security_policy & IPC_FEATURE_EVENT_TREE)
+				&& (client->subscribed_events & event_mask(IPC_EVENT_TREE))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void ipc_event_tree_flush(void) {
+	if (!ipc_tree_diff) {
+		return;
+	}
+	// geometry is reported the way the next frame shows it
+	flush_arrange_windows();
+	if (!ipc_event_tree_subscribed()) {
+		tree_diff_free(ipc_tree_diff);
+		ipc_tree_diff = NULL;
+		return;
+	}
+	json_object *patches = tree_diff_update(ipc_tree_diff);
+	if (!patches) {
+		return;
+	}
+	sway_log(L_DEBUG, "Sending tree::patch event with %d patches",
+			json_object_array_length(patches));
+	json_object *obj = json_object_new_object();
+	json_object_object_add(obj, "change", json_object_new_string("patch"));
+	json_object_object_add(obj, "generation", json_object_new_int64((int64_t)get_tree_generation()));
+	json_object_object_add(obj, "patches", patches);
+
+	const char *json_string = json_object_to_json_string(obj);
+	ipc_send_event(json_string, IPC_EVENT_TREE);
 
 	json_object_put(obj); // free
 }
 
+static int ipc_tree_timer_cb(void *data) {
+	flush_arrange_windows();
+	ipc_tree_pending = false;
+	ipc_event_tree_flush();
+	if (ipc_tree_snapshot && !tree_snapshot_update(ipc_tree_snapshot)) {
+		// readers notice the file is stale and ask again
+		tree_snapshot_free(ipc_tree_snapshot);
+		ipc_tree_snapshot = NULL;
+	}
+	return 0;
+}
+
+void ipc_event_tree_changed(void) {
+	if ((!ipc_tree_diff && !ipc_tree_snapshot) || ipc_tree_pending) {
+		return;
+	}
+	if (!ipc_tree_timer && !(ipc_tree_timer = wlc_event_loop_add_timer(ipc_tree_timer_cb, NULL))) {
+		sway_log(L_ERROR, "Unable to schedule tree update");
+		return;
+	}
+	ipc_tree_pending = true;
+	wlc_event_source_timer_update(ipc_tree_timer, 1);
+}
+
 void ipc_event_barconfig_update(struct bar_config *bar) {
 	sway_log(L_DEBUG, "Sending barconfig_update event");
 	json_object *json = ipc_json_describe_bar_config(bar);
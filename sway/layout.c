@@ -1,6 +1,7 @@
 #define _XOPEN_SOURCE 500
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <math.h>
 #include <wlc/wlc.h>
 #include "sway/extensions.h"
@@ -12,6 +13,7 @@
 #include "sway/ipc-server.h"
 #include "sway/border.h"
 #include "sway/layout.h"
+#include "sway/hit_index.h"
 #include "list.h"
 #include "log.h"
 
@@ -63,6 +65,7 @@ void add_child(swayc_t *parent, swayc_t *child) {
 		child->width, child->height, parent, parent->type, parent->width, parent->height);
 	list_add(parent->children, child);
 	child->parent = parent;
+	mark_layout_dirty(child);
 	// set focus for this container
 	if (!parent->focused) {
 		parent->focused = child;
@@ -89,6 +92,7 @@ void insert_child(swayc_t *parent, swayc_t *child, int index) {
 	}
 	list_insert(parent->children, index, child);
 	child->parent = parent;
+	mark_layout_dirty(child);
 	if (!parent->focused) {
 		parent->focused = child;
 	}
@@ -144,6 +148,7 @@ void add_floating(swayc_t *ws, swayc_t *child) {
 	list_add(ws->floating, child);
 	child->parent = ws;
 	child->is_floating = true;
+	mark_layout_dirty(ws);
 	if (!ws->focused) {
 		ws->focused = child;
 	}
@@ -172,6 +177,7 @@ swayc_t *add_sibling(swayc_t *fixed, swayc_t *active) {
 		}
 	}
 	active->parent = parent;
+	mark_layout_dirty(active);
 	// focus new child
 	parent->focused = active;
 	return active->parent;
@@ -190,6 +196,7 @@ swayc_t *replace_child(swayc_t *child, swayc_t *new_child) {
 	}
 	// Set parent and focus for new_child
 	new_child->parent = child->parent;
+	mark_layout_dirty(new_child);
 	if (child->parent->focused == child) {
 		child->parent->focused = new_child;
 	}
@@ -279,6 +286,7 @@ swayc_t *remove_child(swayc_t *child) {
 		}
 	}
 	child->parent = NULL;
+	mark_layout_dirty(parent);
 	// deactivate view
 	if (child->type == C_VIEW) {
 		wlc_view_set_state(child->handle, WLC_BIT_ACTIVATED, false);
@@ -308,6 +316,8 @@ void swap_container(swayc_t *a, swayc_t *b) {
 	}
 	a->parent = b_parent;
 	b->parent = a_parent;
+	mark_layout_dirty(a);
+	mark_layout_dirty(b);
 	if (a_parent->focused == a) {
 		a_parent->focused = b;
 	}
@@ -571,11 +581,11 @@ void move_container_to(swayc_t* container, swayc_t* destination) {
 	swayc_t *op1 = swayc_parent_by_type(destination, C_OUTPUT);
 	swayc_t *op2 = swayc_parent_by_type(parent, C_OUTPUT);
 	set_focused_container(get_focused_view(op1));
-	arrange_windows(op1, -1, -1);
+	schedule_arrange_windows(op1);
 	update_visibility(op1);
 	if (op1 != op2) {
 		set_focused_container(get_focused_view(op2));
-		arrange_windows(op2, -1, -1);
+		schedule_arrange_windows(op2);
 		update_visibility(op2);
 	}
 }
@@ -748,6 +758,8 @@ void update_geometry(swayc_t *container) {
 	if (container->type != C_VIEW && container->type != C_CONTAINER) {
 		return;
 	}
+	hit_index_invalidate(container);
+	bump_tree_generation();
 
 	swayc_t *workspace = swayc_parent_by_type(container, C_WORKSPACE);
 	swayc_t *op = workspace->parent;
@@ -926,7 +938,11 @@ void update_geometry(swayc_t *container) {
 	}
 
 	if (container->type == C_VIEW) {
-		wlc_view_set_geometry(container->handle, 0, &geometry);
+		// don't make the client reconfigure if nothing changed
+		const struct wlc_geometry *current = wlc_view_get_geometry(container->handle);
+		if (!current || !wlc_geometry_equals(current, &geometry)) {
+			wlc_view_set_geometry(container->handle, 0, &geometry);
+		}
 	}
 }
 
@@ -950,7 +966,63 @@ static void apply_auto_layout(swayc_t *container, const double x, const double y
 				enum swayc_layouts group_layout,
 				bool master_first);
 
-static void arrange_windows_r(swayc_t *container, double width, double height) {
+static void arrange_windows_r(swayc_t *container, double width, double height);
+
+void mark_layout_dirty(swayc_t *container) {
+	// no early exit on dirty ancestors, a layout pass started further down
+	// the tree only cleans up the part it arranged
+	for (swayc_t *c = container; c; c = c->parent) {
+		c->layout_dirty = true;
+	}
+	hit_index_invalidate(container);
+	bump_tree_generation();
+}
+
+static void get_layout_input(swayc_t *container, double width, double height,
+		struct layout_input *input) {
+	// padding must compare equal as well
+	memset(input, 0, sizeof(*input));
+	if (width == -1 || height == -1) {
+		width = container->width;
+		height = container->height;
+	}
+	input->x = container->x;
+	input->y = container->y;
+	input->width = floor(width);
+	input->height = floor(height);
+	input->layout = container->layout;
+	input->border_type = container->border_type;
+	input->border_thickness = container->border_thickness;
+	input->gap = swayc_gap(container);
+	input->nb_master = container->nb_master;
+	input->nb_slave_groups = container->nb_slave_groups;
+	input->fullscreen = swayc_is_fullscreen(container);
+	input->tabbed_stacked = swayc_tabbed_stacked_ancestor(container) != NULL;
+
+	swayc_t *parent = container->parent;
+	input->parent_layout = parent->layout;
+	input->siblings = parent->children->length;
+	if (parent->layout == L_TABBED || parent->layout == L_STACKED) {
+		// position of the title bar
+		input->index = index_child(container);
+	}
+
+	swayc_t *ws = swayc_parent_by_type(container, C_WORKSPACE);
+	input->ws_x = ws->x;
+	input->ws_y = ws->y;
+	input->ws_width = ws->width;
+	input->ws_height = ws->height;
+	input->workspace_children = ws->children->length;
+	input->output_width = ws->parent->width;
+	input->output_height = ws->parent->height;
+
+	input->font_height = config->font_height;
+	input->hide_edge_borders = config->hide_edge_borders;
+	input->edge_gaps = config->edge_gaps;
+	input->smart_gaps = config->smart_gaps;
+}
+
+static void arrange_container(swayc_t *container, double width, double height) {
 	int i;
 	if (width == -1 || height == -1) {
 		swayc_log(L_DEBUG, container, "Arranging layout for %p", container);
@@ -1124,6 +1196,56 @@ static void arrange_windows_r(swayc_t *container, double width, double height) {
 	}
 }
 
+/**
+ * Does the part of arranging a skipped subtree that does not depend on its
+ * geometry. Borders also show focus, colors, the font and titles, which may
+ * have changed since, their cache keeps this cheap when they did not.
+ */
+static void refresh_skipped_subtree(swayc_t *container) {
+	if (container->type == C_VIEW) {
+		if (!swayc_is_fullscreen(container)) {
+			update_container_border(container);
+			return;
+		}
+		swayc_t *workspace = swayc_parent_by_type(container, C_WORKSPACE);
+		if (workspace && workspace->parent->focused == workspace) {
+			wlc_view_bring_to_front(container->handle);
+		}
+		return;
+	}
+	for (int i = 0; i < container->children->length; ++i) {
+		refresh_skipped_subtree(container->children->items[i]);
+	}
+}
+
+static void arrange_windows_r(swayc_t *container, double width, double height) {
+	if (container->type != C_CONTAINER && container->type != C_VIEW) {
+		arrange_container(container, width, height);
+		return;
+	}
+
+	struct layout_input input;
+	get_layout_input(container, width, height, &input);
+	struct layout_cache *cache = &container->layout_cache;
+	// the size is checked as well in case it was changed behind our back,
+	// e.g. by resizing, the position is always set by the caller
+	if (cache->valid && !container->layout_dirty
+			&& cache->width == container->width && cache->height == container->height
+			&& memcmp(&cache->input, &input, sizeof(input)) == 0) {
+		sway_log(L_DEBUG, "Layout of %p is unchanged, skipping", container);
+		refresh_skipped_subtree(container);
+		return;
+	}
+
+	arrange_container(container, width, height);
+
+	cache->input = input;
+	cache->width = container->width;
+	cache->height = container->height;
+	cache->valid = true;
+	container->layout_dirty = false;
+}
+
 void apply_horiz_layout(swayc_t *container, const double x, const double y,
 			const double width, const double height,
 			const int start, const int end) {
@@ -1374,11 +1496,100 @@ void apply_auto_layout(swayc_t *container, const double x, const double y,
 }
 
 void arrange_windows(swayc_t *container, double width, double height) {
+	// whoever asked for this knows something changed here
+	container->layout_dirty = true;
 	update_visibility(container);
 	arrange_windows_r(container, width, height);
 	layout_log(&root_container, 0);
 }
 
+static list_t *arrange_queue = NULL;
+static struct arrange_stats arrange_stats = { 0 };
+
+static bool has_pending_ancestor(swayc_t *container) {
+	for (swayc_t *p = container->parent; p; p = p->parent) {
+		if (p->arrange_pending) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void schedule_arrange_windows(swayc_t *container) {
+	if (!sway_assert(container, "Cannot arrange a NULL container")) {
+		return;
+	}
+	arrange_stats.requests++;
+	if (container->arrange_pending || has_pending_ancestor(container)) {
+		return;
+	}
+	if (!arrange_queue) {
+		arrange_queue = create_list();
+	}
+	container->arrange_pending = true;
+	list_add(arrange_queue, container);
+
+	// the queue is flushed before the next frame, make sure there is one
+	swayc_t *output = swayc_parent_by_type(container, C_OUTPUT);
+	if (output) {
+		wlc_output_schedule_render(output->handle);
+	} else {
+		for (int i = 0; i < root_container.children->length; ++i) {
+			output = root_container.children->items[i];
+			wlc_output_schedule_render(output->handle);
+		}
+	}
+}
+
+void flush_arrange_windows(void) {
+	if (!arrange_queue || arrange_queue->length == 0) {
+		return;
+	}
+	// arranging must not queue more work, but swap the queue out anyway so
+	// that nothing can modify the list while it is walked
+	list_t *queue = arrange_queue;
+	arrange_queue = create_list();
+	arrange_stats.flushes++;
+
+	for (int i = 0; i < queue->length; ++i) {
+		swayc_t *container = queue->items[i];
+		// an ancestor queued later covers this container as well
+		if (has_pending_ancestor(container)) {
+			continue;
+		}
+		// detached in the meantime, e.g. moved to the scratchpad
+		if (container->type != C_ROOT && !container->parent) {
+			continue;
+		}
+		arrange_stats.arranged++;
+		arrange_windows(container, -1, -1);
+	}
+	for (int i = 0; i < queue->length; ++i) {
+		swayc_t *container = queue->items[i];
+		container->arrange_pending = false;
+	}
+	sway_log(L_DEBUG, "Arranged %d queued containers (%lu requests, %lu layout passes so far)",
+			queue->length, arrange_stats.requests, arrange_stats.arranged);
+	list_free(queue);
+}
+
+void cancel_arrange_windows(swayc_t *container) {
+	if (!container->arrange_pending || !arrange_queue) {
+		return;
+	}
+	for (int i = 0; i < arrange_queue->length; ++i) {
+		if (arrange_queue->items[i] == container) {
+			list_del(arrange_queue, i);
+			break;
+		}
+	}
+	container->arrange_pending = false;
+}
+
+const struct arrange_stats *get_arrange_stats(void) {
+	return &arrange_stats;
+}
+
 void arrange_backgrounds(void) {
 	struct background_config *bg;
 	for (int i = 0; i < desktop_shell.backgrounds->length; ++i) {
@@ -0,0 +1,103 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "sway/mark_index.h"
+#include "hashmap.h"
+#include "intern.h"
+#include "list.h"
+#include "log.h"
+
+// mark -> swayc_t, the keys are the interned marks of the containers
+static hashmap_t *marks = NULL;
+
+static hashmap_t *get_marks(void) {
+	if (!marks) {
+		marks = create_hashmap(hash_string, compare_string);
+	}
+	return marks;
+}
+
+static void release_mark(swayc_t *container, int index) {
+	const char *mark = container->marks->items[index];
+	if (marks && hashmap_get(marks, mark) == container) {
+		hashmap_del(marks, mark);
+	}
+	list_del(container->marks, index);
+	intern_release(mark);
+	if (container->marks->length == 0) {
+		list_free(container->marks);
+		container->marks = NULL;
+	}
+}
+
+static int find_mark(swayc_t *container, const char *mark) {
+	if (!container->marks || !mark) {
+		return -1;
+	}
+	return list_seq_find(container->marks, (int (*)(const void *, const void *))strcmp, mark);
+}
+
+bool container_has_mark(swayc_t *container, const char *mark) {
+	return mark_index_find(mark) == container;
+}
+
+void container_add_mark(swayc_t *container, const char *mark) {
+	const char *interned = intern_string(mark);
+	if (!interned || !get_marks()) {
+		sway_log(L_ERROR, "Unable to allocate mark %s", mark);
+		intern_release(interned);
+		return;
+	}
+	swayc_t *owner = hashmap_get(marks, interned);
+	if (owner == container) {
+		intern_release(interned);
+		return;
+	}
+	if (owner) {
+		release_mark(owner, find_mark(owner, mark));
+	}
+	if (!hashmap_set(marks, interned, container)) {
+		sway_log(L_ERROR, "Unable to allocate mark %s", mark);
+		intern_release(interned);
+		return;
+	}
+	if (!container->marks) {
+		container->marks = create_list();
+	}
+	list_add(container->marks, (void *)interned);
+}
+
+bool container_remove_mark(swayc_t *container, const char *mark) {
+	if (mark_index_find(mark) != container) {
+		return false;
+	}
+	release_mark(container, find_mark(container, mark));
+	return true;
+}
+
+void container_clear_marks(swayc_t *container) {
+	while (container->marks) {
+		release_mark(container, container->marks->length - 1);
+	}
+}
+
+swayc_t *mark_index_find(const char *mark) {
+	return marks && mark ? hashmap_get(marks, mark) : NULL;
+}
+
+struct foreach_data {
+	void (*f)(const char *mark, swayc_t *container, void *data);
+	void *data;
+};
+
+static void foreach_mark(const void *key, void *value, void *_data) {
+	struct foreach_data *data = _data;
+	data->f(key, value, data->data);
+}
+
+void mark_index_foreach(void (*f)(const char *mark, swayc_t *container, void *data), void *data) {
+	if (marks) {
+		struct foreach_data foreach_data = { f, data };
+		hashmap_foreach(marks, foreach_mark, &foreach_data);
+	}
+}
@@ -4,10 +4,29 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include "sway/config.h"
 #include "sway/security.h"
+#include "hashmap.h"
 #include "log.h"
 
+/**
+ * Feature policy resolved for a client process. These are kept for as long as
+ * the process has views, so that input handling does not have to go through
+ * /proc for every event.
+ */
+struct pid_policy {
+	pid_t pid;
+	unsigned long long start_time;
+	char *exe;
+	uint32_t features;
+	int refs;
+};
+
+// pid_t -> struct pid_policy
+static hashmap_t *pid_policies = NULL;
+
 static bool validate_ipc_target(const char *program) {
 	struct stat sb;
 
@@ -160,16 +179,15 @@ struct feature_policy *get_feature_policy(const char *name) {
 	return policy;
 }
 
-uint32_t get_feature_policy_mask(pid_t pid) {
+static uint32_t feature_policy_mask_for(const char *exe) {
 	uint32_t default_policy = 0;
-	const char *link = get_pid_exe(pid);
 
 	for (int i = 0; i < config->feature_policies->length; ++i) {
 		struct feature_policy *policy = config->feature_policies->items[i];
 		if (strcmp(policy->program, "*") == 0) {
 			default_policy = policy->features;
 		}
-		if (strcmp(policy->program, link) == 0) {
+		if (strcmp(policy->program, exe) == 0) {
 			return policy->features;
 		}
 	}
@@ -177,6 +195,97 @@ uint32_t get_feature_policy_mask(pid_t pid) {
 	return default_policy;
 }
 
+static unsigned long long get_pid_start_time(pid_t pid) {
+#ifdef __linux__
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		return 0;
+	}
+	char buf[1024];
+	size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+	fclose(f);
+	buf[len] = '\0';
+
+	// comm (field 2) may contain spaces, start after its closing paren
+	char *field = strrchr(buf, ')');
+	// starttime is field 22
+	for (int i = 2; field && i < 22; ++i) {
+		field = strchr(field + 1, ' ');
+	}
+	return field ? strtoull(field + 1, NULL, 10) : 0;
+#else
+	return 0;
+#endif
+}
+
+void cache_feature_policy_mask(pid_t pid) {
+	if (!pid_policies) {
+		pid_policies = create_hashmap(hash_ptr, compare_ptr);
+		if (!pid_policies) {
+			return;
+		}
+	}
+	unsigned long long start_time = get_pid_start_time(pid);
+	struct pid_policy *cached = hashmap_get(pid_policies, (void *)(intptr_t)pid);
+	if (cached) {
+		cached->refs++;
+		if (cached->start_time == start_time) {
+			return;
+		}
+		sway_log(L_DEBUG, "pid %d was reused, resolving its security policy again", pid);
+		free(cached->exe);
+	} else {
+		cached = calloc(1, sizeof(struct pid_policy));
+		if (!cached) {
+			sway_log(L_ERROR, "Unable to allocate security policy cache entry");
+			return;
+		}
+		cached->pid = pid;
+		cached->refs = 1;
+		if (!hashmap_set(pid_policies, (void *)(intptr_t)pid, cached)) {
+			sway_log(L_ERROR, "Unable to allocate security policy cache entry");
+			free(cached);
+			return;
+		}
+	}
+	cached->start_time = start_time;
+	cached->exe = strdup(get_pid_exe(pid));
+	cached->features = feature_policy_mask_for(cached->exe ? cached->exe : "*");
+}
+
+void uncache_feature_policy_mask(pid_t pid) {
+	if (!pid_policies) {
+		return;
+	}
+	struct pid_policy *cached = hashmap_get(pid_policies, (void *)(intptr_t)pid);
+	if (cached && --cached->refs <= 0) {
+		hashmap_del(pid_policies, (void *)(intptr_t)pid);
+		free(cached->exe);
+		free(cached);
+	}
+}
+
+static void refresh_pid_policy(const void *key, void *value, void *data) {
+	struct pid_policy *cached = value;
+	cached->features = feature_policy_mask_for(cached->exe ? cached->exe : "*");
+}
+
+void invalidate_feature_policy_cache(void) {
+	// the executables are still valid, only the policies may have changed
+	hashmap_foreach(pid_policies, refresh_pid_policy, NULL);
+}
+
+uint32_t get_feature_policy_mask(pid_t pid) {
+	struct pid_policy *cached = pid_policies ?
+		hashmap_get(pid_policies, (void *)(intptr_t)pid) : NULL;
+	if (cached) {
+		return cached->features;
+	}
+	return feature_policy_mask_for(get_pid_exe(pid));
+}
+
 uint32_t get_ipc_policy_mask(pid_t pid) {
 	uint32_t default_policy = 0;
 	const char *link = get_pid_exe(pid);
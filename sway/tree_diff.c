@@ -0,0 +1,254 @@
+#define _XOPEN_SOURCE 500
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <json-c/json.h>
+#include "sway/container.h"
+#include "sway/ipc-json.h"
+#include "sway/tree_diff.h"
+#include "hashmap.h"
+#include "list.h"
+#include "log.h"
+
+struct tree_node {
+	size_t id;
+	size_t parent;
+	bool in_floating;
+	int index;
+	int x, y, width, height;
+	char *name;
+	const char *layout; // static, from ipc_json_container_layout
+	enum swayc_border_types border;
+	bool visible, is_floating, sticky, fullscreen;
+	// update pass that last saw the container
+	unsigned int seen;
+};
+
+struct tree_diff {
+	hashmap_t *nodes;
+	size_t focus;
+	unsigned int pass;
+};
+
+static void free_node(const void *key, void *value, void *data) {
+	struct tree_node *node = value;
+	free(node->name);
+	free(node);
+}
+
+void tree_diff_free(struct tree_diff *diff) {
+	if (!diff) {
+		return;
+	}
+	if (diff->nodes) {
+		hashmap_foreach(diff->nodes, free_node, NULL);
+		hashmap_free(diff->nodes);
+	}
+	free(diff);
+}
+
+static bool string_changed(const char *a, const char *b) {
+	if (!a || !b) {
+		return a != b;
+	}
+	return strcmp(a, b) != 0;
+}
+
+static json_object *new_patch(const char *op, size_t id) {
+	json_object *patch = json_object_new_object();
+	json_object_object_add(patch, "op", json_object_new_string(op));
+	json_object_object_add(patch, "id", json_object_new_int((int)id));
+	return patch;
+}
+
+static void add_position(json_object *patch, struct tree_node *node) {
+	json_object_object_add(patch, "parent", json_object_new_int((int)node->parent));
+	json_object_object_add(patch, "list",
+			json_object_new_string(node->in_floating ? "floating_nodes" : "nodes"));
+	json_object_object_add(patch, "index", json_object_new_int(node->index));
+}
+
+static json_object *geometry_patch(struct tree_node *node) {
+	json_object *patch = new_patch("geometry", node->id);
+	json_object *rect = json_object_new_object();
+	json_object_object_add(rect, "x", json_object_new_int(node->x));
+	json_object_object_add(rect, "y", json_object_new_int(node->y));
+	json_object_object_add(rect, "width", json_object_new_int(node->width));
+	json_object_object_add(rect, "height", json_object_new_int(node->height));
+	json_object_object_add(patch, "rect", rect);
+	return patch;
+}
+
+static json_object *properties_patch(struct tree_node *node) {
+	json_object *patch = new_patch("properties", node->id);
+	json_object_object_add(patch, "name",
+			node->name ? json_object_new_string(node->name) : NULL);
+	json_object_object_add(patch, "layout",
+			node->layout ? json_object_new_string(node->layout) : NULL);
+	json_object_object_add(patch, "border",
+			json_object_new_string(ipc_json_border_description(node->border)));
+	json_object_object_add(patch, "visible", json_object_new_boolean(node->visible));
+	json_object_object_add(patch, "floating", json_object_new_boolean(node->is_floating));
+	json_object_object_add(patch, "sticky", json_object_new_boolean(node->sticky));
+	json_object_object_add(patch, "fullscreen_mode", json_object_new_int(node->fullscreen ? 1 : 0));
+	return patch;
+}
+
+struct update_state {
+	struct tree_diff *diff;
+	json_object *patches;
+};
+
+static void emit(struct update_state *state, json_object *patch) {
+	if (state->patches) {
+		json_object_array_add(state->patches, patch);
+	} else {
+		json_object_put(patch);
+	}
+}
+
+static void update_node(struct update_state *state, swayc_t *c,
+		swayc_t *parent, bool in_floating, int index) {
+	struct tree_diff *diff = state->diff;
+	struct tree_node *node = hashmap_get(diff->nodes, (void *)(uintptr_t)c->id);
+	bool added = false;
+	if (!node) {
+		if (!(node = calloc(1, sizeof(struct tree_node)))) {
+			sway_log(L_ERROR, "Unable to allocate tree diff node");
+			return;
+		}
+		node->id = c->id;
+		if (!hashmap_set(diff->nodes, (void *)(uintptr_t)node->id, node)) {
+			sway_log(L_ERROR, "Unable to allocate tree diff node");
+			free(node);
+			return;
+		}
+		added = true;
+	}
+	node->seen = diff->pass;
+
+	size_t parent_id = parent ? parent->id : 0;
+	bool moved = node->parent != parent_id || node->in_floating != in_floating
+		|| node->index != index;
+	node->parent = parent_id;
+	node->in_floating = in_floating;
+	node->index = index;
+
+	bool geometry = node->x != (int)c->x || node->y != (int)c->y
+		|| node->width != (int)c->width || node->height != (int)c->height;
+	node->x = (int)c->x;
+	node->y = (int)c->y;
+	node->width = (int)c->width;
+	node->height = (int)c->height;
+
+	// as get_tree has it, a view changes when its parent's layout does
+	const char *layout = ipc_json_container_layout(c);
+	bool fullscreen = c->type == C_VIEW && swayc_is_fullscreen(c);
+	bool properties = string_changed(node->name, c->name) || string_changed(node->layout, layout)
+		|| node->border != c->border_type || node->visible != c->visible
+		|| node->is_floating != c->is_floating || node->sticky != c->sticky
+		|| node->fullscreen != fullscreen;
+	if (string_changed(node->name, c->name)) {
+		free(node->name);
+		node->name = c->name ? strdup(c->name) : NULL;
+	}
+	node->layout = layout;
+	node->border = c->border_type;
+	node->visible = c->visible;
+	node->is_floating = c->is_floating;
+	node->sticky = c->sticky;
+	node->fullscreen = fullscreen;
+
+	if (added) {
+		json_object *patch = new_patch("add", node->id);
+		add_position(patch, node);
+		if (state->patches) {
+			json_object_object_add(patch, "node", ipc_json_describe_container(c));
+		}
+		emit(state, patch);
+	} else {
+		if (moved) {
+			json_object *patch = new_patch("move", node->id);
+			add_position(patch, node);
+			emit(state, patch);
+		}
+		if (geometry) {
+			emit(state, geometry_patch(node));
+		}
+		if (properties) {
+			emit(state, properties_patch(node));
+		}
+	}
+
+	// parents are visited before their children, so adds come in an
+	// order that can be applied
+	if (c->type == C_VIEW) {
+		return;
+	}
+	for (int i = 0; c->children && i < c->children->length; ++i) {
+		update_node(state, c->children->items[i], c, false, i);
+	}
+	for (int i = 0; c->floating && i < c->floating->length; ++i) {
+		update_node(state, c->floating->items[i], c, true, i);
+	}
+}
+
+struct removal_state {
+	unsigned int pass;
+	list_t *removed;
+};
+
+static void find_removed(const void *key, void *value, void *data) {
+	struct tree_node *node = value;
+	struct removal_state *state = data;
+	if (node->seen != state->pass) {
+		list_add(state->removed, node);
+	}
+}
+
+/**
+ * Runs an update pass, collecting patches into patches unless it is NULL.
+ */
+static void update(struct tree_diff *diff, json_object *patches) {
+	struct update_state state = { diff, patches };
+	diff->pass++;
+	update_node(&state, &root_container, NULL, false, 0);
+
+	struct removal_state removal = { diff->pass, create_list() };
+	hashmap_foreach(diff->nodes, find_removed, &removal);
+	for (int i = 0; i < removal.removed->length; ++i) {
+		struct tree_node *node = removal.removed->items[i];
+		emit(&state, new_patch("remove", node->id));
+		hashmap_del(diff->nodes, (void *)(uintptr_t)node->id);
+		free_node(NULL, node, NULL);
+	}
+	list_free(removal.removed);
+
+	size_t focus = current_focus ? current_focus->id : 0;
+	if (focus != diff->focus) {
+		diff->focus = focus;
+		emit(&state, new_patch("focus", focus));
+	}
+}
+
+struct tree_diff *tree_diff_create(void) {
+	struct tree_diff *diff = calloc(1, sizeof(struct tree_diff));
+	if (!diff || !(diff->nodes = create_hashmap(hash_ptr, compare_ptr))) {
+		sway_log(L_ERROR, "Unable to allocate tree diff");
+		free(diff);
+		return NULL;
+	}
+	update(diff, NULL);
+	return diff;
+}
+
+json_object *tree_diff_update(struct tree_diff *diff) {
+	json_object *patches = json_object_new_array();
+	update(diff, patches);
+	if (json_object_array_length(patches) == 0) {
+		json_object_put(patches);
+		return NULL;
+	}
+	return patches;
+}
@@ -0,0 +1,255 @@
+#define _XOPEN_SOURCE 700
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "sway/container.h"
+#include "sway/tree_snapshot.h"
+#include "ipc-snapshot.h"
+#include "hashmap.h"
+#include "log.h"
+#include "shm.h"
+
+// the trees start after the header, on their own cache line
+static const size_t header_size = 64;
+
+struct tree_snapshot {
+	int fd;
+	int read_fd;
+	char *map;
+	size_t size;
+
+	bool published;
+	uint64_t generation;
+	// location of the published tree
+	size_t offset, length;
+
+	// the next tree is built here before it is copied into the file
+	struct ipc_snapshot_node *nodes;
+	uint32_t node_count, node_capacity;
+	int32_t focused;
+	char *strings;
+	size_t strings_length, strings_capacity;
+	// string -> pool offset + 1, only valid while building
+	hashmap_t *interned;
+	bool error;
+};
+
+static bool resize(struct tree_snapshot *snapshot, size_t size) {
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size = (size + page - 1) / page * page;
+	if (ftruncate(snapshot->fd, size) == -1) {
+		sway_log_errno(L_ERROR, "Unable to grow tree snapshot");
+		return false;
+	}
+	char *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, snapshot->fd, 0);
+	if (map == MAP_FAILED) {
+		sway_log_errno(L_ERROR, "Unable to map tree snapshot");
+		return false;
+	}
+	if (snapshot->map) {
+		munmap(snapshot->map, snapshot->size);
+	}
+	snapshot->map = map;
+	snapshot->size = size;
+	return true;
+}
+
+void tree_snapshot_free(struct tree_snapshot *snapshot) {
+	if (!snapshot) {
+		return;
+	}
+	if (snapshot->map) {
+		struct ipc_snapshot_header *header = (struct ipc_snapshot_header *)snapshot->map;
+		uint32_t sequence = header->sequence;
+		__atomic_store_n(&header->sequence, sequence + 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		header->flags |= IPC_SNAPSHOT_STALE;
+		__atomic_store_n(&header->sequence, sequence + 2, __ATOMIC_RELEASE);
+		munmap(snapshot->map, snapshot->size);
+	}
+	if (snapshot->fd != -1) {
+		close(snapshot->fd);
+	}
+	if (snapshot->read_fd != -1) {
+		close(snapshot->read_fd);
+	}
+	if (snapshot->interned) {
+		hashmap_free(snapshot->interned);
+	}
+	free(snapshot->nodes);
+	free(snapshot->strings);
+	free(snapshot);
+}
+
+struct tree_snapshot *tree_snapshot_create(void) {
+	struct tree_snapshot *snapshot = calloc(1, sizeof(struct tree_snapshot));
+	if (!snapshot) {
+		sway_log(L_ERROR, "Unable to allocate tree snapshot");
+		return NULL;
+	}
+	snapshot->read_fd = -1;
+	snapshot->fd = create_shm_file("sway-tree-snapshot", 0, &snapshot->read_fd);
+	if (snapshot->fd == -1) {
+		sway_log_errno(L_ERROR, "Unable to create tree snapshot file");
+		tree_snapshot_free(snapshot);
+		return NULL;
+	}
+	if (!(snapshot->interned = create_hashmap(hash_string, compare_string))
+			|| !resize(snapshot, header_size + 16384)) {
+		tree_snapshot_free(snapshot);
+		return NULL;
+	}
+
+	struct ipc_snapshot_header *header = (struct ipc_snapshot_header *)snapshot->map;
+	header->magic = IPC_SNAPSHOT_MAGIC;
+	header->version = IPC_SNAPSHOT_VERSION;
+	header->size = snapshot->size;
+	if (!tree_snapshot_update(snapshot)) {
+		tree_snapshot_free(snapshot);
+		return NULL;
+	}
+	return snapshot;
+}
+
+int tree_snapshot_get_fd(struct tree_snapshot *snapshot) {
+	return fcntl(snapshot->read_fd, F_DUPFD_CLOEXEC, 0);
+}
+
+static uint32_t intern(struct tree_snapshot *snapshot, const char *str) {
+	if (!str) {
+		return IPC_SNAPSHOT_NO_STRING;
+	}
+	uintptr_t offset = (uintptr_t)hashmap_get(snapshot->interned, str);
+	if (offset) {
+		return (uint32_t)(offset - 1);
+	}
+	size_t length = strlen(str) + 1;
+	if (snapshot->strings_length + length > snapshot->strings_capacity) {
+		size_t capacity = snapshot->strings_capacity ? snapshot->strings_capacity : 4096;
+		while (capacity < snapshot->strings_length + length) {
+			capacity *= 2;
+		}
+		char *strings = realloc(snapshot->strings, capacity);
+		if (!strings) {
+			snapshot->error = true;
+			return IPC_SNAPSHOT_NO_STRING;
+		}
+		snapshot->strings = strings;
+		snapshot->strings_capacity = capacity;
+	}
+	offset = snapshot->strings_length;
+	memcpy(snapshot->strings + offset, str, length);
+	snapshot->strings_length += length;
+	// if this fails the string is only stored again the next time
+	hashmap_set(snapshot->interned, str, (void *)(offset + 1));
+	return (uint32_t)offset;
+}
+
+static void add_node(struct tree_snapshot *snapshot, swayc_t *c, int32_t parent) {
+	if (snapshot->node_count == snapshot->node_capacity) {
+		uint32_t capacity = snapshot->node_capacity ? snapshot->node_capacity * 2 : 64;
+		struct ipc_snapshot_node *nodes = realloc(snapshot->nodes,
+				capacity * sizeof(struct ipc_snapshot_node));
+		if (!nodes) {
+			snapshot->error = true;
+			return;
+		}
+		snapshot->nodes = nodes;
+		snapshot->node_capacity = capacity;
+	}
+	int32_t index = (int32_t)snapshot->node_count++;
+	struct ipc_snapshot_node *node = &snapshot->nodes[index];
+	node->id = c->id;
+	node->parent = parent;
+	node->type = (uint32_t)c->type;
+	node->x = (int32_t)c->x;
+	node->y = (int32_t)c->y;
+	node->width = (int32_t)c->width;
+	node->height = (int32_t)c->height;
+	node->flags = (c->visible ? IPC_SNAPSHOT_VISIBLE : 0)
+		| (c->is_floating ? IPC_SNAPSHOT_FLOATING : 0)
+		| (c->is_focused ? IPC_SNAPSHOT_FOCUSED : 0)
+		| (c->sticky ? IPC_SNAPSHOT_STICKY : 0)
+		| (c->type == C_VIEW && swayc_is_fullscreen(c) ? IPC_SNAPSHOT_FULLSCREEN : 0);
+	node->name = intern(snapshot, c->name);
+	node->class = intern(snapshot, c->type == C_VIEW ? c->class : NULL);
+	node->app_id = intern(snapshot, c->type == C_VIEW ? c->app_id : NULL);
+	if (c == current_focus) {
+		snapshot->focused = index;
+	}
+
+	if (c->type == C_VIEW) {
+		return;
+	}
+	for (int i = 0; c->children && i < c->children->length; ++i) {
+		add_node(snapshot, c->children->items[i], index);
+	}
+	for (int i = 0; c->floating && i < c->floating->length; ++i) {
+		add_node(snapshot, c->floating->items[i], index);
+	}
+}
+
+bool tree_snapshot_update(struct tree_snapshot *snapshot) {
+	uint64_t generation = get_tree_generation();
+	if (snapshot->published && snapshot->generation == generation) {
+		return true;
+	}
+
+	snapshot->node_count = 0;
+	snapshot->strings_length = 0;
+	snapshot->focused = -1;
+	snapshot->error = false;
+	add_node(snapshot, &root_container, -1);
+	// the keys point into the tree, don't keep them around
+	hashmap_clear(snapshot->interned);
+	if (snapshot->error) {
+		sway_log(L_ERROR, "Unable to allocate tree snapshot");
+		return false;
+	}
+
+	size_t nodes_size = snapshot->node_count * sizeof(struct ipc_snapshot_node);
+	size_t length = sizeof(struct ipc_snapshot_tree) + nodes_size + snapshot->strings_length;
+	length = (length + 7) & ~(size_t)7;
+
+	// never write over the published tree, readers may be looking at it
+	size_t offset = header_size;
+	if (snapshot->published && offset + length > snapshot->offset) {
+		offset = (snapshot->offset + snapshot->length + 63) & ~(size_t)63;
+	}
+	if (offset + length > snapshot->size) {
+		size_t size = snapshot->size * 2;
+		if (!resize(snapshot, size > offset + length ? size : offset + length)) {
+			return false;
+		}
+	}
+
+	char *tree_data = snapshot->map + offset;
+	struct ipc_snapshot_tree tree = {
+		.generation = generation,
+		.length = (uint32_t)length,
+		.node_count = snapshot->node_count,
+		.focused = snapshot->focused,
+		.strings = (uint32_t)(sizeof(struct ipc_snapshot_tree) + nodes_size),
+	};
+	memcpy(tree_data, &tree, sizeof(tree));
+	memcpy(tree_data + sizeof(tree), snapshot->nodes, nodes_size);
+	memcpy(tree_data + tree.strings, snapshot->strings, snapshot->strings_length);
+
+	struct ipc_snapshot_header *header = (struct ipc_snapshot_header *)snapshot->map;
+	uint32_t sequence = header->sequence;
+	__atomic_store_n(&header->sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	header->size = snapshot->size;
+	header->offset = offset;
+	__atomic_store_n(&header->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+	snapshot->published = true;
+	snapshot->generation = generation;
+	snapshot->offset = offset;
+	snapshot->length = length;
+	return true;
+}
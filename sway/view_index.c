@@ -0,0 +1,125 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "sway/view_index.h"
+#include "hashmap.h"
+#include "log.h"
+
+struct view_entry {
+	const char *value;
+	swayc_t *view;
+};
+
+// entries sorted by value, then by con_id, so prefixes are ranges
+struct attribute_index {
+	struct view_entry *entries;
+	int length, capacity;
+};
+
+static struct attribute_index attributes[VIEW_ATTRIBUTE_COUNT];
+// con_id -> swayc_t
+static hashmap_t *ids = NULL;
+
+static const char *attribute_value(swayc_t *view, enum view_attribute attribute) {
+	switch (attribute) {
+	case VIEW_CLASS:
+		return view->class;
+	case VIEW_INSTANCE:
+		return view->instance;
+	case VIEW_APP_ID:
+		return view->app_id;
+	default:
+		return NULL;
+	}
+}
+
+// Returns the position of the first entry not before value/id.
+static int lower_bound(struct attribute_index *index, const char *value, size_t id) {
+	int low = 0, high = index->length;
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+		struct view_entry *entry = &index->entries[mid];
+		int cmp = strcmp(entry->value, value);
+		if (cmp < 0 || (cmp == 0 && entry->view->id < id)) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+static void attribute_add(struct attribute_index *index, const char *value, swayc_t *view) {
+	if (index->length == index->capacity) {
+		int capacity = index->capacity ? index->capacity * 2 : 64;
+		struct view_entry *entries = realloc(index->entries,
+				capacity * sizeof(struct view_entry));
+		if (!entries) {
+			sway_log(L_ERROR, "Unable to grow view index");
+			return;
+		}
+		index->entries = entries;
+		index->capacity = capacity;
+	}
+	int i = lower_bound(index, value, view->id);
+	memmove(&index->entries[i + 1], &index->entries[i],
+			(index->length - i) * sizeof(struct view_entry));
+	index->entries[i] = (struct view_entry){ value, view };
+	index->length++;
+}
+
+static void attribute_remove(struct attribute_index *index, const char *value, swayc_t *view) {
+	int i = lower_bound(index, value, view->id);
+	if (i < index->length && index->entries[i].view == view) {
+		memmove(&index->entries[i], &index->entries[i + 1],
+				(index->length - i - 1) * sizeof(struct view_entry));
+		index->length--;
+	}
+}
+
+void view_index_add(swayc_t *view) {
+	if (!ids && !(ids = create_hashmap(hash_ptr, compare_ptr))) {
+		sway_log(L_ERROR, "Unable to allocate view index");
+		return;
+	}
+	if (!hashmap_set(ids, (void *)(uintptr_t)view->id, view)) {
+		sway_log(L_ERROR, "Unable to index view %zu", view->id);
+	}
+	for (int i = 0; i < VIEW_ATTRIBUTE_COUNT; ++i) {
+		const char *value = attribute_value(view, i);
+		if (value) {
+			attribute_add(&attributes[i], value, view);
+		}
+	}
+}
+
+void view_index_remove(swayc_t *view) {
+	if (!ids || hashmap_get(ids, (void *)(uintptr_t)view->id) != view) {
+		return;
+	}
+	hashmap_del(ids, (void *)(uintptr_t)view->id);
+	for (int i = 0; i < VIEW_ATTRIBUTE_COUNT; ++i) {
+		const char *value = attribute_value(view, i);
+		if (value) {
+			attribute_remove(&attributes[i], value, view);
+		}
+	}
+}
+
+swayc_t *view_index_by_id(size_t id) {
+	return ids ? hashmap_get(ids, (void *)(uintptr_t)id) : NULL;
+}
+
+void view_index_find(list_t *views, enum view_attribute attribute,
+		const char *value, bool prefix) {
+	struct attribute_index *index = &attributes[attribute];
+	size_t length = strlen(value);
+	for (int i = lower_bound(index, value, 0); i < index->length; ++i) {
+		const char *entry = index->entries[i].value;
+		if (prefix ? strncmp(entry, value, length) != 0 : strcmp(entry, value) != 0) {
+			break;
+		}
+		list_add(views, index->entries[i].view);
+	}
+}
@@ -318,7 +318,7 @@ bool workspace_switch(swayc_t *workspace) {
 	}
 	swayc_t *output = swayc_parent_by_type(workspace, C_OUTPUT);
 	arrange_backgrounds();
-	arrange_windows(output, -1, -1);
+	schedule_arrange_windows(output);
 	return true;
 }
 
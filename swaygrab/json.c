@@ -104,6 +104,8 @@ char *create_payload(const char *output, struct wlc_geometry *g) {
 	json_object_object_add(payload, "y", json_object_new_int(g->origin.y));
 	json_object_object_add(payload, "w", json_object_new_int(g->size.w));
 	json_object_object_add(payload, "h", json_object_new_int(g->size.h));
+	// read the pixels from shared memory instead of the socket
+	json_object_object_add(payload, "shm", json_object_new_boolean(true));
 
 	snprintf(payload_str, 256, "%s", json_object_to_json_string(payload));
 	return strdup(payload_str);
@@ -7,12 +7,19 @@
 #include <getopt.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <math.h>
 #include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
 #include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <json-c/json.h>
 #include "log.h"
 #include "ipc-client.h"
+#include "ipc-capture.h"
 #include "util.h"
 #include "swaygrab/json.h"
 
@@ -20,16 +27,73 @@ void sway_terminate(int exit_code) {
 	exit(exit_code);
 }
 
+// shared memory sway reads the pixels into, kept across frames
+static char *shm_pixels = NULL;
+static size_t shm_size = 0;
+
+static void map_shm_pixels(int fd) {
+	if (shm_pixels) {
+		munmap(shm_pixels, shm_size);
+		shm_pixels = NULL;
+	}
+	struct stat st;
+	if (fstat(fd, &st) == -1) {
+		sway_abort("Unable to get the size of the pixel buffer");
+	}
+	shm_size = st.st_size;
+	shm_pixels = mmap(NULL, shm_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm_pixels == MAP_FAILED) {
+		sway_abort("Unable to map the pixel buffer");
+	}
+}
+
+/**
+ * Requests the pixels described by payload and returns them, either from the
+ * shared buffer or from the reply (then *reply has to be freed). width and
+ * height are 0 if the output is unknown.
+ */
+static char *get_pixels(int socketfd, const char *payload, uint32_t *width,
+		uint32_t *height, uint32_t *len, char **reply) {
+	ipc_send_command(socketfd, IPC_SWAY_GET_PIXELS, payload, strlen(payload));
+	struct ipc_response *resp = ipc_recv_response(socketfd);
+	if (!resp || resp->size < 9) {
+		sway_abort("Invalid get_pixels response");
+	}
+	uint32_t dimensions[2];
+	memcpy(dimensions, resp->payload + 1, sizeof(dimensions));
+	*width = dimensions[0];
+	*height = dimensions[1];
+
+	char *pixels;
+	if (resp->payload[0] == 2) {
+		// sway hands out a new buffer whenever the old one is too small
+		if (resp->fd != -1) {
+			map_shm_pixels(resp->fd);
+			resp->fd = -1;
+		}
+		*len = *width * *height * 4;
+		if (!shm_pixels || *len > shm_size) {
+			sway_abort("Pixel buffer is too small");
+		}
+		pixels = shm_pixels;
+		*reply = NULL;
+		free_ipc_response(resp);
+	} else {
+		*len = resp->size - 9;
+		pixels = resp->payload + 9;
+		*reply = resp->payload;
+		resp->payload = NULL;
+		free_ipc_response(resp);
+	}
+	return pixels;
+}
+
 void grab_and_apply_magick(const char *file, const char *payload,
 		int socketfd, int raw) {
-	uint32_t len = strlen(payload);
-	char *pixels = ipc_single_command(socketfd,
-			IPC_SWAY_GET_PIXELS, payload, &len);
-	uint32_t *u32pixels = (uint32_t *)(pixels + 1);
-	uint32_t width = u32pixels[0];
-	uint32_t height = u32pixels[1];
-	len -= 9;
-	pixels += 9;
+	uint32_t width, height, len;
+	char *reply;
+	char *pixels = get_pixels(socketfd, payload, &width, &height, &len, &reply);
 
 	if (width == 0 || height == 0) {
 		// indicates geometry was clamped by WLC because it was outside of the output's area
@@ -44,7 +108,7 @@ void grab_and_apply_magick(const char *file, const char *payload,
 	if (raw) {
 		fwrite(pixels, 1, len, stdout);
 		fflush(stdout);
-		free(pixels - 9);
+		free(reply);
 		return;
 	}
 
@@ -62,7 +126,7 @@ void grab_and_apply_magick(const char *file, const char *payload,
 		close(fd[0]);
 		write(fd[1], pixels, len);
 		close(fd[1]);
-		free(pixels - 9);
+		free(reply);
 		waitpid(child, NULL, 0);
 	} else {
 		close(fd[1]);
@@ -76,76 +140,201 @@ void grab_and_apply_magick(const char *file, const char *payload,
 	}
 }
 
+static void release_frame(int socketfd, uint32_t buffer) {
+	char payload[32];
+	snprintf(payload, sizeof(payload), "{\"release\": %" PRIu32 "}", buffer);
+	ipc_send_command(socketfd, IPC_SWAY_CAPTURE, payload, strlen(payload));
+}
+
+static volatile sig_atomic_t stop_capture = 0;
+
+static void handle_stop(int signal) {
+	stop_capture = 1;
+}
+
+/**
+ * Runs cmd through the shell in a process group of its own, so that a ctrl+c
+ * meant for swaygrab doesn't end ffmpeg before the last frame was written.
+ * Returns a stream to its stdin.
+ */
+static FILE *run_encoder(const char *cmd, pid_t *child) {
+	int fd[2];
+	if (pipe(fd) == -1) {
+		return NULL;
+	}
+	if ((*child = fork()) < 0) {
+		close(fd[0]);
+		close(fd[1]);
+		return NULL;
+	} else if (*child == 0) {
+		setpgid(0, 0);
+		close(fd[1]);
+		if (dup2(fd[0], 0) != 0) {
+			sway_log(L_ERROR, "Could not fdup the pipe");
+		}
+		close(fd[0]);
+		execl("/bin/sh", "sh", "-c", cmd, NULL);
+		_exit(EXIT_FAILURE);
+	}
+	close(fd[0]);
+	return fdopen(fd[1], "w");
+}
+
+// Number of frame periods from start to the current time.
+static uint64_t elapsed_slots(uint64_t start, uint64_t period) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	uint64_t time = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+	return time > start ? (time - start) / period : 0;
+}
+
 void grab_and_apply_movie_magic(const char *file, const char *payload,
 		int socketfd, int raw, int framerate) {
 	if (raw) {
 		sway_log(L_ERROR, "Raw capture data is not yet supported. Proceeding with ffmpeg normally.");
 	}
 
-	uint32_t len = strlen(payload);
-	char *pixels = ipc_single_command(socketfd,
-			IPC_SWAY_GET_PIXELS, payload, &len);
-	uint32_t *u32pixels = (uint32_t *)(pixels + 1);
-	uint32_t width = u32pixels[0];
-	uint32_t height = u32pixels[1];
-	pixels += 9;
-
-	if (width == 0 || height == 0) {
-		// indicates geometry was clamped by WLC because it was outside of the output's area
+	ipc_send_command(socketfd, IPC_SWAY_CAPTURE, payload, strlen(payload));
+	struct ipc_response *resp = ipc_recv_response(socketfd);
+	json_object *reply = resp ? json_tokener_parse(resp->payload) : NULL;
+	json_object *success, *buffer_size;
+	if (!reply || !json_object_object_get_ex(reply, "success", &success)
+			|| !json_object_get_boolean(success) || resp->fd == -1) {
 		json_object *obj = json_tokener_parse(payload);
 		json_object *output;
 		json_object_object_get_ex(obj, "output", &output);
-		const char *name = json_object_get_string(output);
-		json_object_put(obj);
-		sway_abort("Unknown output %s.", name);
+		sway_abort("Unable to capture output %s.", json_object_get_string(output));
 	}
+	json_object_object_get_ex(reply, "buffer_size", &buffer_size);
+	size_t frame_size = (size_t)json_object_get_int64(buffer_size);
+	map_shm_pixels(resp->fd);
+	resp->fd = -1;
+	json_object_put(reply);
+	free_ipc_response(resp);
 
 	char *ffmpeg_opts = getenv("SWAYGRAB_FFMPEG_OPTS");
 	if(!ffmpeg_opts) {
 			ffmpeg_opts = "";
 	}
 
-	const char *fmt = "ffmpeg %s -f rawvideo -framerate %d "
-		"-video_size %dx%d -pixel_format argb "
-		"-i pipe:0 -r %d -vf vflip %s";
-	char *cmd = malloc(strlen(fmt) - 8 /*args*/
-			+ strlen(ffmpeg_opts) + numlen(width) + numlen(height)
-			+ numlen(framerate) * 2 + strlen(file) + 1);
-	sprintf(cmd, fmt, ffmpeg_opts, framerate, width, height, framerate, file);
-
-	long ns = (long)(1000000000 * (1.0 / framerate));
-	struct timespec start, finish, ts;
-	ts.tv_sec = 0;
-
-	FILE *f = popen(cmd, "w");
-	fwrite(pixels, 1, len, f);
-	free(pixels - 9);
-	int sleep = 0;
-	while (sleep != -1) {
-		clock_gettime(CLOCK_MONOTONIC, &start);
-		len = strlen(payload);
-		pixels = ipc_single_command(socketfd,
-				IPC_SWAY_GET_PIXELS, payload, &len);
-		pixels += 9;
-		len -= 9;
-
-		fwrite(pixels, 1, len, f);
-
-		free(pixels - 9);
-		clock_gettime(CLOCK_MONOTONIC, &finish);
-		ts.tv_nsec = ns;
-		double fts = (double)finish.tv_sec + 1.0e-9*finish.tv_nsec;
-		double sts = (double)start.tv_sec + 1.0e-9*start.tv_nsec;
-		long diff = (fts - sts) * 1000000000;
-		ts.tv_nsec = ns - diff;
-		if (ts.tv_nsec < 0) {
-			ts.tv_nsec = 0;
+	// without SA_RESTART, poll returns when one of these arrives
+	struct sigaction action = { .sa_handler = handle_stop };
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	// a failing ffmpeg shows up as a failed write
+	signal(SIGPIPE, SIG_IGN);
+
+	// sway sends a frame whenever the output was rendered, which is not at
+	// any fixed rate. The video has a frame every period: each one shows the
+	// frame held at that time, which is repeated until the next one arrives,
+	// and frames rendered faster than framerate are dropped.
+	uint64_t period = 1000000000 / framerate;
+	uint64_t start = 0, written = 0;
+	struct ipc_capture_frame held;
+	bool holding = false;
+	FILE *f = NULL;
+	pid_t child = -1;
+	char *cmd = NULL;
+	uint32_t width = 0, height = 0;
+
+	while (!stop_capture) {
+		int timeout = -1;
+		if (holding) {
+			// wake up in time to repeat the held frame, the period rounded up
+			timeout = elapsed_slots(start, period) > written ? 0 :
+				(int)((period + 999999) / 1000000);
 		}
-		sleep = nanosleep(&ts, NULL);
+		struct pollfd pfd = { .fd = socketfd, .events = POLLIN };
+		int ready = poll(&pfd, 1, timeout);
+		if (ready == -1 && errno == EINTR) {
+			continue;
+		} else if (ready == -1) {
+			sway_log_errno(L_ERROR, "Unable to wait for frames");
+			break;
+		}
+
+		if (pfd.revents & (POLLHUP | POLLERR)) {
+			sway_log(L_INFO, "Sway closed the connection");
+			break;
+		} else if (ready == 0) {
+			uint64_t slots = holding ? elapsed_slots(start, period) : 0;
+			for (; written < slots; ++written) {
+				if (fwrite(shm_pixels + held.buffer * frame_size, 1,
+						(size_t)width * height * 4, f) == 0) {
+					stop_capture = 1;
+					break;
+				}
+			}
+			continue;
+		}
+
+		resp = ipc_recv_response(socketfd);
+		if (resp->type != (uint32_t)IPC_EVENT_CAPTURE) {
+			// replies to releases
+			free_ipc_response(resp);
+			continue;
+		}
+		struct ipc_capture_frame frame;
+		if (resp->size < sizeof(frame)) {
+			sway_abort("Invalid capture frame");
+		}
+		memcpy(&frame, resp->payload, sizeof(frame));
+		free_ipc_response(resp);
+		if ((frame.buffer + 1) * frame_size > shm_size
+				|| (size_t)frame.width * frame.height * 4 > frame_size) {
+			sway_abort("Capture frame is out of bounds");
+		}
+		if (frame.skipped) {
+			sway_log(L_DEBUG, "Sway skipped %" PRIu32 " frames", frame.skipped);
+		}
+
+		if (!f) {
+			width = frame.width;
+			height = frame.height;
+			const char *fmt = "ffmpeg %s -f rawvideo -framerate %d "
+				"-video_size %dx%d -pixel_format argb "
+				"-i pipe:0 -r %d -vf vflip %s";
+			cmd = malloc(strlen(fmt) - 8 /*args*/
+					+ strlen(ffmpeg_opts) + numlen(width) + numlen(height)
+					+ numlen(framerate) * 2 + strlen(file) + 1);
+			sprintf(cmd, fmt, ffmpeg_opts, framerate, width, height, framerate, file);
+			f = run_encoder(cmd, &child);
+			if (!f) {
+				sway_abort("Unable to run ffmpeg");
+			}
+			start = frame.time;
+		} else if (frame.width != width || frame.height != height) {
+			sway_abort("Capture size changed from %dx%d to %dx%d",
+					width, height, frame.width, frame.height);
+		}
+
+		if (holding) {
+			// the held frame was on screen until this one replaced it
+			uint64_t slots = frame.time > start ? (frame.time - start) / period : 0;
+			for (; written < slots; ++written) {
+				fwrite(shm_pixels + held.buffer * frame_size, 1,
+						(size_t)width * height * 4, f);
+			}
+			release_frame(socketfd, held.buffer);
+		}
+		held = frame;
+		holding = true;
 	}
-	fflush(f);
 
-	fclose(f);
+	if (f) {
+		// the held frame is still on screen, it fills the slots up to now
+		// and at least the one it arrived in
+		uint64_t slots = elapsed_slots(start, period) + 1;
+		for (; holding && written < slots; ++written) {
+			if (fwrite(shm_pixels + held.buffer * frame_size, 1,
+					(size_t)width * height * 4, f) == 0) {
+				break;
+			}
+		}
+		fclose(f);
+		waitpid(child, NULL, 0);
+	}
 	free(cmd);
 }
 
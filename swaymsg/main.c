@@ -309,6 +309,10 @@ int main(int argc, char **argv) {
 		type = IPC_GET_VERSION;
 	} else if (strcasecmp(cmdtype, "get_clipboard") == 0) {
 		type = IPC_GET_CLIPBOARD;
+	} else if (strcasecmp(cmdtype, "get_tree_generation") == 0) {
+		type = IPC_SWAY_GET_TREE_GENERATION;
+	} else if (strcasecmp(cmdtype, "get_containers") == 0) {
+		type = IPC_SWAY_GET_CONTAINERS;
 	} else {
 		sway_abort("Unknown message type %s", cmdtype);
 	}